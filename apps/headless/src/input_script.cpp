@@ -0,0 +1,109 @@
+#include "input_script.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "lib/common.hpp"
+
+namespace {
+auto parse_state(const std::string& token, const usize line_number) -> u8 {
+  usize length = 0;
+  unsigned long value = 0;
+
+  try {
+    value = std::stoul(token, &length, 16);
+  } catch (const std::logic_error&) {
+    length = 0;
+  }
+
+  if (length != token.size() || value > 0xFF) {
+    throw std::invalid_argument(
+      std::format("Input script line {}: invalid button state '{}'", line_number, token)
+    );
+  }
+
+  return static_cast<u8>(value);
+}
+} // namespace
+
+auto InputScript::load(const std::filesystem::path& path) -> InputScript {
+  auto file = std::ifstream(path);
+
+  if (!file) {
+    throw std::runtime_error(std::format("Can't open the input script {}", path.string()));
+  }
+
+  return parse(file);
+}
+
+auto InputScript::parse(std::istream& input) -> InputScript {
+  auto script = InputScript();
+  auto line = std::string();
+  usize line_number = 0;
+
+  while (std::getline(input, line)) {
+    ++line_number;
+
+    auto words = std::istringstream(line.substr(0, line.find('#')));
+    auto frame = std::string();
+
+    if (!(words >> frame)) {
+      continue; // Blank line or comment
+    }
+
+    auto change = Change{.frame = 0, .state = {}};
+    usize length = 0;
+
+    try {
+      change.frame = std::stoull(frame, &length);
+    } catch (const std::logic_error&) {
+      length = 0;
+    }
+
+    if (length != frame.size()) {
+      throw std::invalid_argument(
+        std::format("Input script line {}: invalid frame '{}'", line_number, frame)
+      );
+    }
+
+    if (!script.changes.empty() && change.frame <= script.changes.back().frame) {
+      throw std::invalid_argument(
+        std::format("Input script line {}: frames must be increasing", line_number)
+      );
+    }
+
+    auto token = std::string();
+    usize port = 0;
+
+    for (; port < change.state.size() && words >> token; ++port) {
+      change.state[port] = parse_state(token, line_number);
+    }
+
+    if (port == 0 || words >> token) {
+      throw std::invalid_argument(
+        std::format("Input script line {}: expected one or two button states", line_number)
+      );
+    }
+
+    script.changes.push_back(change);
+  }
+
+  return script;
+}
+
+auto InputScript::get_state(const usize frame) const -> State {
+  const auto next = std::ranges::upper_bound(changes, frame, {}, &Change::frame);
+
+  if (next == changes.begin()) {
+    return {};
+  }
+
+  return std::prev(next)->state;
+}
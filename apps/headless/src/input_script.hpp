@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <istream>
+#include <vector>
+
+#include "lib/common.hpp"
+
+// Controller states by frame, read from a text file with one change per line:
+//
+//   # frame  port 1  [port 2]  (hexadecimal button states, held until the next line)
+//   0        00
+//   120      08               # Start
+//   125      00
+//
+// An empty script never presses anything.
+class InputScript {
+public:
+  using State = std::array<u8, 2>;
+
+  InputScript() = default;
+
+  [[nodiscard]] static auto load(const std::filesystem::path& path) -> InputScript;
+  [[nodiscard]] static auto parse(std::istream& input) -> InputScript;
+
+  [[nodiscard]] auto get_state(usize frame) const -> State;
+
+private:
+  struct Change {
+    usize frame;
+    State state;
+  };
+
+  std::vector<Change> changes; // In frame order
+};
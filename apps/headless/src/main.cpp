@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "input_script.hpp"
+#include "lib/common.hpp"
+#include "nes/constants.hpp"
+#include "nes/movie.hpp"
+#include "nes/nes.hpp"
+
+// Runs a ROM without a window as fast as possible and reports the frame times, e.g. to measure
+// a change of the core or to check its output in CI
+
+namespace {
+constexpr usize DEFAULT_FRAME_COUNT = 600;
+
+constexpr auto USAGE = std::string_view(
+  "Usage: {} <rom> [options]\n"
+  "  --frames <n>     Frames measured (default 600, or the rest of the movie)\n"
+  "  --warmup <n>     Frames run before measuring (default 0)\n"
+  "  --input <file>   Input script, see input_script.hpp (default: no buttons pressed)\n"
+  "  --movie <file>   Replay a movie, checking its hashes (instead of --input)\n"
+  "  --record <file>  Record the run into a movie\n"
+  "  --audio          Synthesize the audio too (and discard it)\n"
+  "  --hash           Print the hash of the last frame\n"
+  "  --ppm <file>     Save the last frame as a PPM image"
+);
+
+struct Options {
+  std::filesystem::path rom_path;
+  std::optional<usize> frame_count;
+  usize warmup_frames = 0;
+  std::optional<std::filesystem::path> input_path;
+  std::optional<std::filesystem::path> movie_path;
+  std::optional<std::filesystem::path> record_path;
+  std::optional<std::filesystem::path> ppm_path;
+  bool is_audio_enabled = false;
+  bool print_hash = false;
+};
+
+auto parse_count(const std::string_view option, const std::string_view value) -> usize {
+  const auto text = std::string(value);
+  usize length = 0;
+  usize count = 0;
+
+  try {
+    count = std::stoull(text, &length);
+  } catch (const std::logic_error&) {
+    length = 0;
+  }
+
+  if (length != text.size()) {
+    throw std::invalid_argument(std::format("Invalid value for {}: '{}'", option, value));
+  }
+
+  return count;
+}
+
+auto parse_options(const std::vector<std::string_view>& args) -> Options {
+  if (args.size() < 2) {
+    throw std::invalid_argument("Missing ROM path");
+  }
+
+  auto options = Options();
+  options.rom_path = args[1];
+
+  for (usize i = 2; i < args.size(); ++i) {
+    const auto option = args[i];
+
+    const auto value = [&] {
+      if (i + 1 == args.size()) {
+        throw std::invalid_argument(std::format("Missing value for {}", option));
+      }
+
+      return args[++i];
+    };
+
+    if (option == "--frames") {
+      options.frame_count = parse_count(option, value());
+    } else if (option == "--warmup") {
+      options.warmup_frames = parse_count(option, value());
+    } else if (option == "--input") {
+      options.input_path = value();
+    } else if (option == "--movie") {
+      options.movie_path = value();
+    } else if (option == "--record") {
+      options.record_path = value();
+    } else if (option == "--ppm") {
+      options.ppm_path = value();
+    } else if (option == "--audio") {
+      options.is_audio_enabled = true;
+    } else if (option == "--hash") {
+      options.print_hash = true;
+    } else {
+      throw std::invalid_argument(std::format("Unknown option {}", option));
+    }
+  }
+
+  if (options.frame_count == 0) {
+    throw std::invalid_argument("At least one frame must be measured");
+  }
+
+  if (options.movie_path && (options.input_path || options.record_path)) {
+    throw std::invalid_argument("--movie can't be combined with --input or --record");
+  }
+
+  return options;
+}
+
+void write_ppm(nes::Nes& nes, const std::filesystem::path& path) {
+  auto file = std::ofstream(path, std::ios::binary);
+
+  if (!file) {
+    throw std::runtime_error(std::format("Can't create {}", path.string()));
+  }
+
+  file << std::format("P6\n{} {}\n255\n", nes::SCREEN_WIDTH, nes::SCREEN_HEIGHT);
+
+  const auto* pixels = nes.get_frame_buffer();
+  auto row = std::vector<char>(usize{nes::SCREEN_WIDTH} * 3);
+
+  for (usize y = 0; y < nes::SCREEN_HEIGHT; ++y) {
+    for (usize x = 0; x < nes::SCREEN_WIDTH; ++x) {
+      const auto colour = pixels[(y * nes::SCREEN_WIDTH) + x]; // XRGB8888
+
+      row[(x * 3) + 0] = static_cast<char>((colour >> 16) & 0xFF);
+      row[(x * 3) + 1] = static_cast<char>((colour >> 8) & 0xFF);
+      row[(x * 3) + 2] = static_cast<char>(colour & 0xFF);
+    }
+
+    file.write(row.data(), static_cast<std::streamsize>(row.size()));
+  }
+}
+
+// Nearest rank
+auto percentile(const std::vector<std::chrono::nanoseconds>& sorted, const double fraction)
+  -> std::chrono::nanoseconds {
+  const auto rank = static_cast<usize>(fraction * static_cast<double>(sorted.size() - 1));
+  return sorted[rank];
+}
+
+void run(const Options& options, const std::filesystem::path& app_path) {
+  const auto input = options.input_path ? InputScript::load(*options.input_path) : InputScript();
+
+  auto nes = nes::Nes();
+  nes.set_app_path(app_path);
+  nes.load(options.rom_path);
+
+  // Both power on the console
+  auto player = std::optional<nes::MoviePlayer>();
+  auto recorder = std::optional<nes::MovieRecorder>();
+
+  if (options.movie_path) {
+    player.emplace(nes::Movie::load(*options.movie_path), nes);
+  } else if (options.record_path) {
+    recorder.emplace(nes);
+  } else {
+    nes.power_on();
+  }
+
+  nes.set_audio_enabled(options.is_audio_enabled);
+
+  const auto movie_frames = player ? player->get_movie().size() : usize{0};
+
+  if (player && movie_frames <= options.warmup_frames) {
+    throw std::invalid_argument("The movie is shorter than the warmup");
+  }
+
+  const auto frame_count = options.frame_count.value_or(
+    player ? movie_frames - options.warmup_frames : DEFAULT_FRAME_COUNT
+  );
+  const auto total_frames = player ? std::min(options.warmup_frames + frame_count, movie_frames)
+                                   : options.warmup_frames + frame_count;
+
+  auto samples = std::vector<float>(4096);
+  auto frame_times = std::vector<std::chrono::nanoseconds>();
+  frame_times.reserve(total_frames - options.warmup_frames);
+
+  for (usize frame = 0; frame < total_frames; ++frame) {
+    const auto start = std::chrono::steady_clock::now();
+
+    if (player) {
+      player->run_frame(nes);
+    } else if (recorder) {
+      recorder->run_frame(nes, input.get_state(frame));
+    } else {
+      const auto state = input.get_state(frame);
+      nes.update_controller_state(0, state[0]);
+      nes.update_controller_state(1, state[1]);
+      nes.run_frame();
+    }
+
+    if (options.is_audio_enabled) {
+      UNUSED(nes.read_audio_samples(samples));
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+
+    if (frame >= options.warmup_frames) {
+      frame_times.push_back(end - start);
+    }
+  }
+
+  if (recorder) {
+    recorder->get_movie().save(*options.record_path);
+  }
+
+  // Before the frame times are sorted
+  auto total = std::chrono::nanoseconds(0);
+
+  for (const auto time : frame_times) {
+    total += time;
+  }
+
+  std::ranges::sort(frame_times);
+
+  const auto to_us = [](const std::chrono::nanoseconds time) {
+    return std::chrono::duration<double, std::micro>(time).count();
+  };
+
+  const auto seconds = std::chrono::duration<double>(total).count();
+  const auto count = static_cast<double>(frame_times.size());
+
+  std::println(
+    "{}: {} frames ({} warmup)",
+    options.rom_path.string(),
+    frame_times.size(),
+    options.warmup_frames
+  );
+  std::println("{:>12} {:>12.1f}", "frames/s", count / seconds);
+  std::println("{:>12} {:>12.0f}", "ns/frame", static_cast<double>(total.count()) / count);
+  std::println("{:>12} {:>12.1f}", "min us", to_us(frame_times.front()));
+  std::println("{:>12} {:>12.1f}", "p50 us", to_us(percentile(frame_times, 0.50)));
+  std::println("{:>12} {:>12.1f}", "p90 us", to_us(percentile(frame_times, 0.90)));
+  std::println("{:>12} {:>12.1f}", "p99 us", to_us(percentile(frame_times, 0.99)));
+  std::println("{:>12} {:>12.1f}", "max us", to_us(frame_times.back()));
+
+  if (player && player->get_movie().has_hashes()) {
+    std::println("{:>12} {} frames match", "movie", player->get_frame());
+  }
+
+  if (options.print_hash) {
+    // Of the palette indices and the colour emphasis, which don't depend on the palette file
+    std::println("{:>12} {:016x}", "hash", nes::Movie::get_hashes(nes).frame);
+  }
+
+  if (options.ppm_path) {
+    write_ppm(nes, *options.ppm_path);
+  }
+}
+} // namespace
+
+auto main(const int argc, char* argv[]) -> int {
+  const auto args = std::vector<std::string_view>(argv, argv + argc);
+
+  auto options = Options();
+
+  try {
+    options = parse_options(args);
+  } catch (const std::invalid_argument& error) {
+    std::println(stderr, "Error: {}", error.what());
+    std::println(stderr, USAGE, args[0]);
+    return EXIT_FAILURE;
+  }
+
+  try {
+    run(options, std::filesystem::path(args[0]).parent_path());
+  } catch (const std::exception& error) {
+    std::println(stderr, "Error: {}", error.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -1,13 +1,20 @@
 #include "app.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <exception>
 #include <format>
 #include <span>
 #include <stdexcept>
+#include <stop_token>
 #include <string>
 #include <string_view>
+#include <thread>
 
 #include "lib/common.hpp"
+#include "lib/spsc_ring.hpp"
 #include "nes/constants.hpp"
 #include "nes/nes.hpp"
 #include "sdl/sdl.hpp"
@@ -16,6 +23,9 @@
 using nes::Nes;
 
 namespace {
+// Nes::run_frame() runs 29781 CPU cycles at 1.789773MHz (NTSC)
+constexpr auto FRAME_DURATION = std::chrono::nanoseconds(16'639'540);
+
 void render_display(const sdl::Renderer& renderer, const sdl::Texture& texture) {
   const auto available_size = renderer.get_current_render_output_size();
   const auto rect = integer_scale_centered_rect(
@@ -27,6 +37,31 @@ void render_display(const sdl::Renderer& renderer, const sdl::Texture& texture)
 
   SDL_RenderTexture(renderer.get(), texture.get(), nullptr, nullptr);
 }
+
+// Runs on SDL's audio thread. Whatever the ring is missing is played as silence.
+void audio_callback(
+  void* userdata,
+  SDL_AudioStream* stream,
+  const int additional_amount,
+  const int total_amount
+) {
+  UNUSED(total_amount);
+
+  auto& ring = *static_cast<lib::SpscRing<float>*>(userdata);
+  auto buffer = std::array<float, 1024>();
+  auto remaining = static_cast<usize>(additional_amount) / sizeof(float);
+
+  while (remaining > 0) {
+    const auto count = ring.pop(std::span(buffer).first(std::min(remaining, buffer.size())));
+
+    if (count == 0) {
+      break;
+    }
+
+    SDL_PutAudioStreamData(stream, buffer.data(), static_cast<int>(count * sizeof(float)));
+    remaining -= count;
+  }
+}
 } // namespace
 
 App::App(const std::span<std::string_view> args) {
@@ -44,7 +79,7 @@ void App::run() {
   nes.load(rom_path);
   nes.power_on();
 
-  auto context = sdl::Context{SDL_INIT_VIDEO | SDL_INIT_GAMEPAD};
+  auto context = sdl::Context{SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMEPAD};
 
   constexpr auto window_flags = SDL_WindowFlags{SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIDDEN};
 
@@ -70,6 +105,16 @@ void App::run() {
 
   texture.set_scale_mode(SDL_SCALEMODE_NEAREST);
 
+  const auto audio_spec = SDL_AudioSpec{
+    .format = SDL_AUDIO_F32,
+    .channels = 1,
+    .freq = static_cast<int>(nes::AUDIO_SAMPLE_RATE),
+  };
+  const auto audio_stream = sdl::AudioStream(audio_spec, audio_callback, &audio_ring);
+
+  audio_stream.resume();
+  nes.set_audio_enabled(true);
+
   {
     int numkeys = 0;
     const auto raw_keys = SDL_GetKeyboardState(&numkeys);
@@ -78,18 +123,28 @@ void App::run() {
 
   setup_default_bindings();
 
+  // Owns the console from here on. Leaving run() stops it, and it powers the console off.
+  // It can't throw: errors are handed over and rethrown here, which stops it the same way.
+  const auto emulation_thread = std::jthread([this, &nes](const std::stop_token& stop_token) {
+    emulate(stop_token, nes);
+  });
+
   auto fps_timer = std::chrono::steady_clock::now();
   i32 elapsed_frames = 0;
-
-  running = true;
+  u64 last_frame_number = 0;
 
   while (true) {
+    if (has_emulation_error.load(std::memory_order_acquire)) {
+      std::rethrow_exception(emulation_error);
+    }
+
     SDL_Event event;
 
     while (SDL_PollEvent(&event)) {
       switch (event.type) {
-        case SDL_EVENT_QUIT: nes.power_off(); return;
-        case SDL_EVENT_KEY_DOWN: process_input(event.key, nes); break;
+        case SDL_EVENT_QUIT: return;
+
+        case SDL_EVENT_KEY_DOWN: process_input(event.key); break;
 
         default: break;
       }
@@ -100,33 +155,49 @@ void App::run() {
       }
     }
 
+    update_emulated_controllers();
+    is_rewinding.store(keys[action_key_bindings[Action::Rewind]], std::memory_order_relaxed);
+
+    if (frames.update()) {
+      SDL_UpdateTexture(
+        texture.get(),
+        nullptr,
+        frames.read_buffer().pixels.data(),
+        nes::SCREEN_WIDTH * sizeof(u32)
+      );
+    }
+
     {
       using namespace std::chrono_literals;
 
       auto elapsed_time = std::chrono::steady_clock::now() - fps_timer;
 
       if (elapsed_time > 1s) {
-        auto fps = elapsed_frames / std::chrono::duration<double>(elapsed_time).count();
-        auto title = std::format("{} | {:5.2f}fps", nes::TITLE, fps);
+        const auto& frame = frames.read_buffer();
+        const auto seconds = std::chrono::duration<double>(elapsed_time).count();
+        const auto fps = elapsed_frames / seconds;
+        const auto emulation_fps = static_cast<double>(frame.number - last_frame_number) / seconds;
+
+        auto title = std::format(
+          "{} | {:5.2f}fps | emulation {:5.2f}fps{} | volume {:.0f}% | run-ahead {} | rewind "
+          "{:.1f}s, {:.1f}MB/min",
+          nes::TITLE,
+          fps,
+          emulation_fps,
+          frame.is_limited ? "" : " (unlimited)",
+          frame.volume * 100.0,
+          frame.run_ahead_frames,
+          static_cast<double>(frame.rewind_frames) / 60.0,
+          static_cast<double>(frame.rewind_memory_per_minute) / (1024.0 * 1024.0)
+        );
         SDL_SetWindowTitle(window.get(), title.c_str());
 
         fps_timer = std::chrono::steady_clock::now();
         elapsed_frames = 0;
+        last_frame_number = frame.number;
       }
     }
 
-    if (running) {
-      update_emulated_controllers(nes);
-      nes.run_frame();
-    }
-
-    SDL_UpdateTexture(
-      texture.get(),
-      nullptr,
-      nes.get_frame_buffer(),
-      nes::SCREEN_WIDTH * sizeof(u32)
-    );
-
     SDL_RenderClear(renderer.get());
     render_display(renderer, texture);
     SDL_RenderPresent(renderer.get());
@@ -135,6 +206,104 @@ void App::run() {
   }
 }
 
+// Runs frames until the stop is requested, at the NES frame rate unless the limiter is off.
+// A late frame only delays the next ones by the time lost, but after falling a whole frame
+// behind (unlimited speed, a stall) the pace restarts from the present. An exception stops it
+// too, and is kept for the main thread.
+void App::emulate(const std::stop_token& stop_token, Nes& nes) {
+  auto next_frame = std::chrono::steady_clock::now();
+
+  try {
+    while (!stop_token.stop_requested()) {
+      auto action = Action::Pause;
+
+      while (actions.pop(std::span(&action, 1)) != 0) {
+        handle_action(action, nes);
+      }
+
+      if (is_running) {
+        emulate_frame(nes);
+        publish_frame(nes);
+      }
+
+      if (!is_limited && is_running) {
+        next_frame = std::chrono::steady_clock::now();
+        continue;
+      }
+
+      next_frame += FRAME_DURATION;
+      const auto now = std::chrono::steady_clock::now();
+
+      if (now - next_frame > FRAME_DURATION) {
+        next_frame = now;
+      }
+
+      std::this_thread::sleep_until(next_frame);
+    }
+  } catch (...) {
+    emulation_error = std::current_exception();
+  }
+
+  // Also after an error, to save the PRG-RAM
+  try {
+    run_ahead.restore(nes);
+    nes.power_off();
+  } catch (...) {
+    if (!emulation_error) {
+      emulation_error = std::current_exception();
+    }
+  }
+
+  has_emulation_error.store(emulation_error != nullptr, std::memory_order_release);
+}
+
+void App::emulate_frame(Nes& nes) {
+  if (is_rewinding.load(std::memory_order_relaxed)) {
+    run_ahead.clear();
+    rewind.step_back(nes);
+    return;
+  }
+
+  nes.update_controller_state(0, controller_state.load(std::memory_order_relaxed));
+
+  if (run_ahead_frames != 0) {
+    run_ahead.run_frame(nes);
+    rewind.push(run_ahead.get_state());
+  } else {
+    nes.run_frame();
+    rewind.push(nes);
+  }
+
+  queue_audio(nes);
+}
+
+void App::publish_frame(Nes& nes) {
+  auto& frame = frames.write_buffer();
+  const auto* pixels = nes.get_frame_buffer();
+
+  std::copy_n(pixels, frame.pixels.size(), frame.pixels.begin());
+
+  frame.number = ++frame_number;
+  frame.volume = volume;
+  frame.is_limited = is_limited;
+  frame.run_ahead_frames = run_ahead_frames;
+  frame.rewind_frames = rewind.size();
+  frame.rewind_memory_per_minute = rewind.memory_per_minute();
+
+  frames.publish();
+}
+
+void App::queue_audio(Nes& nes) {
+  const auto samples = std::span(audio_samples).first(nes.read_audio_samples(audio_samples));
+
+  for (auto& sample : samples) {
+    sample *= static_cast<float>(volume);
+  }
+
+  // Samples that don't fit are dropped, the ring only holds a few frames
+  audio_ring.push(samples);
+}
+
 void App::setup_default_bindings() {
   action_key_bindings[Action::Pause] = SDL_SCANCODE_ESCAPE;
   action_key_bindings[Action::Reset] = SDL_SCANCODE_R;
@@ -143,6 +312,8 @@ void App::setup_default_bindings() {
   action_key_bindings[Action::ToggleLimiter] = SDL_SCANCODE_TAB;
   action_key_bindings[Action::VolumeUp] = SDL_SCANCODE_KP_PLUS;
   action_key_bindings[Action::VolumeDown] = SDL_SCANCODE_KP_MINUS;
+  action_key_bindings[Action::Rewind] = SDL_SCANCODE_GRAVE;
+  action_key_bindings[Action::RunAhead] = SDL_SCANCODE_F5;
 
   controller_key_bindings[Button::A] = SDL_SCANCODE_X;
   controller_key_bindings[Button::B] = SDL_SCANCODE_Z;
@@ -154,7 +325,8 @@ void App::setup_default_bindings() {
   controller_key_bindings[Button::Right] = SDL_SCANCODE_RIGHT;
 }
 
-void App::update_emulated_controllers(Nes& nes) {
+// The emulation thread picks up the latest state at the start of each frame
+void App::update_emulated_controllers() {
   u8 state = 0;
 
   state |= static_cast<u8>(static_cast<u8>(keys[controller_key_bindings[Button::A]]) << 0u);
@@ -166,27 +338,50 @@ void App::update_emulated_controllers(Nes& nes) {
   state |= static_cast<u8>(static_cast<u8>(keys[controller_key_bindings[Button::Left]]) << 6u);
   state |= static_cast<u8>(static_cast<u8>(keys[controller_key_bindings[Button::Right]]) << 7u);
 
-  nes.update_controller_state(0, state);
+  controller_state.store(state, std::memory_order_relaxed);
 }
 
-void App::process_input(const SDL_KeyboardEvent& key_event, Nes& nes) {
+void App::process_input(const SDL_KeyboardEvent& key_event) {
   const auto key = key_event.scancode;
 
   for (const auto& [action, mappedKey] : action_key_bindings) {
-    if (mappedKey != key) {
+    if (mappedKey != key || action == Action::Rewind) { // Rewind is held, see run()
       continue;
     }
 
-    switch (action) {
-      case Action::Pause: running = !running; return;
-      case Action::Reset: nes.reset(); return;
+    actions.push(std::span(&action, 1)); // Dropped if the emulation is far behind
+  }
+}
 
-      case Action::SaveSnapshot:
-      case Action::LoadSnapshot:
-      case Action::ToggleLimiter:
-      case Action::VolumeUp:
-      case Action::VolumeDown:
-      default: return;
-    }
+void App::handle_action(const Action action, Nes& nes) {
+  switch (action) {
+    case Action::Pause: is_running = !is_running; return;
+    case Action::Reset:
+      run_ahead.restore(nes);
+      nes.reset();
+      return;
+
+    case Action::RunAhead:
+      run_ahead.restore(nes);
+      run_ahead_frames = (run_ahead_frames + 1) % (nes::RunAhead::MAX_FRAMES + 1);
+
+      if (run_ahead_frames != 0) {
+        run_ahead.set_frames(run_ahead_frames);
+      }
+      return;
+
+    case Action::ToggleLimiter:
+      // Sped up audio isn't worth listening to, and synthesizing it isn't free
+      is_limited = !is_limited;
+      nes.set_audio_enabled(is_limited);
+      return;
+
+    case Action::VolumeUp: volume = std::min(volume + 0.1, 1.0); return;
+    case Action::VolumeDown: volume = std::max(volume - 0.1, 0.0); return;
+
+    case Action::SaveSnapshot:
+    case Action::LoadSnapshot:
+    case Action::Rewind:
+    default: return;
   }
 }
@@ -1,12 +1,23 @@
 #pragma once
 
+#include <atomic>
+#include <exception>
 #include <map>
 #include <span>
+#include <stop_token>
 #include <string_view>
+#include <vector>
 
+#include "lib/spsc_ring.hpp"
+#include "lib/triple_buffer.hpp"
+#include "nes/constants.hpp"
 #include "nes/nes.hpp"
+#include "nes/rewind.hpp"
+#include "nes/run_ahead.hpp"
 #include "sdl/sdl.hpp"
 
+// The console runs on its own thread, paced by the frame rate of the NES (or as fast as it can
+// with the limiter off), while the main thread handles the window, input and presentation.
 class App {
 public:
   explicit App(std::span<std::string_view> args);
@@ -20,16 +31,43 @@ private:
 
   std::string_view rom_path;
 
-  // double volume = 0.1;
-  bool running = false;
+  //
+  // Emulation thread, everything here is only touched by it
+  //
+
+  void emulate(const std::stop_token& stop_token, nes::Nes& nes);
+  void emulate_frame(nes::Nes& nes);
+  void publish_frame(nes::Nes& nes);
+
+  double volume = 0.5; // Changed with the volume keys
+  bool is_running = true;
+  bool is_limited = true; // Toggled with the limiter key
+  u64 frame_number = 0;
+
+  // Steps back one frame per emulated frame while the rewind key is held
+  nes::Rewind rewind{usize{64} * 1024 * 1024};
+
+  // Frames to run ahead (0 = off), cycled with the run-ahead key
+  usize run_ahead_frames = 0;
+  nes::RunAhead run_ahead;
+
+  //
+  // Audio
+  //
+
+  void queue_audio(nes::Nes& nes);
+
+  // The emulation pushes the samples of each frame, the audio callback drains them
+  lib::SpscRing<float> audio_ring{usize{8192}};
+  std::vector<float> audio_samples = std::vector<float>(4096);
 
   //
   // Input
   //
 
   void setup_default_bindings();
-  void update_emulated_controllers(nes::Nes& nes);
-  void process_input(const SDL_KeyboardEvent& key_event, nes::Nes& nes);
+  void update_emulated_controllers();
+  void process_input(const SDL_KeyboardEvent& key_event);
 
   enum class Button {
     A,
@@ -50,10 +88,39 @@ private:
     ToggleLimiter,
     VolumeUp,
     VolumeDown,
+    Rewind,
+    RunAhead,
   };
 
+  void handle_action(Action action, nes::Nes& nes); // Emulation thread
+
   std::map<Action, SDL_Scancode> action_key_bindings;
   std::map<Button, SDL_Scancode> controller_key_bindings;
 
   std::span<const bool> keys;
+
+  //
+  // Shared between the threads
+  //
+
+  // A finished frame, with the state shown in the window title
+  struct Frame {
+    std::vector<u32> pixels = std::vector<u32>(nes::SCREEN_WIDTH * nes::SCREEN_HEIGHT);
+    u64 number = 0; // Frames emulated so far
+    double volume = 0.0;
+    bool is_limited = true;
+    usize run_ahead_frames = 0;
+    usize rewind_frames = 0;
+    usize rewind_memory_per_minute = 0;
+  };
+
+  lib::TripleBuffer<Frame> frames; // The main thread always shows the newest one
+
+  lib::SpscRing<Action> actions{usize{64}}; // Key presses, handled between frames
+  std::atomic<u8> controller_state = 0;
+  std::atomic<bool> is_rewinding = false; // The rewind key is held
+
+  // What stopped the emulation thread, set before the flag; the main loop rethrows it
+  std::exception_ptr emulation_error;
+  std::atomic<bool> has_emulation_error = false;
 };
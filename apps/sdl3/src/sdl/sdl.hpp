@@ -1,6 +1,7 @@
 #pragma once
 
 // IWYU pragma: begin_exports
+#include "sdl_audio_stream.hpp"
 #include "sdl_context.hpp"
 #include "sdl_error.hpp"
 #include "sdl_include.hpp"
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+
+#include "sdl_error.hpp"
+#include "sdl_include.hpp"
+
+namespace sdl {
+// Stream bound to the default playback device, fed by `callback` on SDL's audio thread
+class AudioStream {
+public:
+  [[nodiscard]]
+  AudioStream(const SDL_AudioSpec& spec, const SDL_AudioStreamCallback callback, void* userdata) {
+    auto* raw =
+      SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, callback, userdata);
+
+    if (raw == nullptr) {
+      throw Error::from_context_with_source("SDL_OpenAudioDeviceStream");
+    }
+
+    pointer.reset(raw);
+  }
+
+  [[nodiscard]]
+  auto get() const -> SDL_AudioStream* {
+    return pointer.get();
+  }
+
+  // The device starts paused
+  void resume() const {
+    const auto result = SDL_ResumeAudioStreamDevice(pointer.get());
+
+    if (!result) {
+      throw Error::from_context_with_source("SDL_ResumeAudioStreamDevice");
+    }
+  }
+
+private:
+  struct Deleter {
+    void operator()(SDL_AudioStream* ptr) const {
+      if (ptr != nullptr) {
+        SDL_DestroyAudioStream(ptr); // Also closes the device
+      }
+    }
+  };
+
+  using Pointer = std::unique_ptr<SDL_AudioStream, Deleter>;
+
+  Pointer pointer;
+};
+} // namespace sdl
@@ -4,6 +4,12 @@ option(ENABLE_CACHE "Enable cache (ccache)" OFF)
 option(ENABLE_CLANG_TIDY "Enable clang-tidy" OFF)
 option(ENABLE_CPPCHECK "Enable cppcheck" OFF)
 option(ENABLE_IWYU "Enable include-what-you-use" OFF)
+option(BUILD_BENCHMARKS "Build the benchmarks" OFF)
+option(ENABLE_PPU_CATCH_UP "Run the PPU lazily instead of stepping it on every CPU cycle" ON)
+option(ENABLE_PPU_SCANLINE_RENDERER "Draw whole scanlines at once when nothing can change mid-line (catch-up PPU only)" ON)
+option(ENABLE_CPU_TABLE_DISPATCH "Dispatch CPU opcodes through a table of handlers instead of a switch" OFF)
+option(ENABLE_CPU_IDLE_LOOP_SKIP "Skip the iterations of polling loops until the next PPU event (catch-up PPU only)" ON)
+option(ENABLE_CPU_BLOCK_CACHE "Run PRG-ROM code from a cache of pre-decoded basic blocks" OFF)
 
 if(ENABLE_IPO)
   include(cmake/InterproceduralOptimization.cmake)
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace lib {
+/// Read-only file mapped in memory copy-on-write: the contents can be modified in memory, which
+/// copies the touched pages only, and the file itself is never written. Unmodified pages stay
+/// shared with the page cache (and other processes mapping the same file).
+class MappedFile {
+public:
+  /// Throws std::runtime_error if the file can't be opened or mapped
+  explicit MappedFile(const std::filesystem::path& path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+  MappedFile(MappedFile&& other) noexcept;
+  auto operator=(MappedFile&& other) noexcept -> MappedFile&;
+
+  [[nodiscard]] auto data() noexcept -> std::span<std::uint8_t>;
+  [[nodiscard]] auto data() const noexcept -> std::span<const std::uint8_t>;
+
+private:
+  void unmap() noexcept;
+
+  std::uint8_t* address = nullptr;
+  std::size_t size = 0;
+};
+} // namespace lib
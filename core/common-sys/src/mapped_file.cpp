@@ -0,0 +1,120 @@
+#include "lib/mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace lib {
+MappedFile::MappedFile(const std::filesystem::path& path) {
+  const auto error = [&path](const std::string_view what) {
+    return std::runtime_error(std::format("Can't {} {}", what, path.string()));
+  };
+
+  size = std::filesystem::file_size(path); // May throw
+
+  if (size == 0) {
+    return; // Empty files can't be mapped
+  }
+
+#ifdef _WIN32
+  auto* const file = CreateFileW(
+    path.c_str(),
+    GENERIC_READ,
+    FILE_SHARE_READ,
+    nullptr,
+    OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL,
+    nullptr
+  );
+
+  if (file == INVALID_HANDLE_VALUE) {
+    throw error("open");
+  }
+
+  // The view keeps the mapping alive, the handles can be closed right away
+  auto* const mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+  CloseHandle(file);
+
+  if (mapping == nullptr) {
+    throw error("map");
+  }
+
+  address = static_cast<std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, size));
+  CloseHandle(mapping);
+
+  if (address == nullptr) {
+    throw error("map");
+  }
+#else
+  const auto file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+  if (file < 0) {
+    throw error("open");
+  }
+
+  // MAP_PRIVATE: writes go to private copies of the pages, the mapping outlives the descriptor
+  auto* const mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+  close(file);
+
+  if (mapped == MAP_FAILED) {
+    throw error("map");
+  }
+
+  address = static_cast<std::uint8_t*>(mapped);
+#endif
+}
+
+MappedFile::~MappedFile() {
+  unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+  address(std::exchange(other.address, nullptr)),
+  size(std::exchange(other.size, 0)) {}
+
+auto MappedFile::operator=(MappedFile&& other) noexcept -> MappedFile& {
+  if (this != &other) {
+    unmap();
+    address = std::exchange(other.address, nullptr);
+    size = std::exchange(other.size, 0);
+  }
+
+  return *this;
+}
+
+auto MappedFile::data() noexcept -> std::span<std::uint8_t> {
+  return {address, address != nullptr ? size : 0};
+}
+
+auto MappedFile::data() const noexcept -> std::span<const std::uint8_t> {
+  return {address, address != nullptr ? size : 0};
+}
+
+void MappedFile::unmap() noexcept {
+  if (address == nullptr) {
+    return;
+  }
+
+#ifdef _WIN32
+  UnmapViewOfFile(address);
+#else
+  munmap(address, size);
+#endif
+
+  address = nullptr;
+  size = 0;
+}
+} // namespace lib
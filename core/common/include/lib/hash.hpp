@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace lib {
+/// 64-bit FNV-1a, fast and good enough to fingerprint emulator state (not for security).
+/// Feeding the same bytes in several calls gives the same hash as in a single one.
+class Fnv1a {
+public:
+  static constexpr std::uint64_t OFFSET_BASIS = 0xCBF2'9CE4'8422'2325;
+  static constexpr std::uint64_t PRIME = 0x0000'0100'0000'01B3;
+
+  constexpr void add(const std::uint8_t byte) noexcept {
+    hash ^= byte;
+    hash *= PRIME;
+  }
+
+  constexpr void add(const std::span<const std::uint8_t> bytes) noexcept {
+    for (const auto byte : bytes) {
+      add(byte);
+    }
+  }
+
+  [[nodiscard]] constexpr auto get() const noexcept -> std::uint64_t {
+    return hash;
+  }
+
+private:
+  std::uint64_t hash = OFFSET_BASIS;
+};
+
+[[nodiscard]] constexpr auto fnv1a(const std::span<const std::uint8_t> bytes) noexcept
+  -> std::uint64_t {
+  auto hash = Fnv1a();
+  hash.add(bytes);
+  return hash.get();
+}
+} // namespace lib
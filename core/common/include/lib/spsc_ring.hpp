@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace lib {
+/// Lock-free ring buffer for exactly one producer thread and one consumer thread.
+/// Both sides transfer as many elements as fit or are available and never block.
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+class SpscRing {
+public:
+  /// `capacity` is rounded up to a power of two
+  explicit SpscRing(const std::size_t capacity) :
+    buffer(std::bit_ceil(std::max(capacity, std::size_t{1}))),
+    mask(buffer.size() - 1) {}
+
+  [[nodiscard]] auto capacity() const noexcept -> std::size_t {
+    return buffer.size();
+  }
+
+  /// Approximate when called concurrently with push or pop
+  [[nodiscard]] auto size() const noexcept -> std::size_t {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+  }
+
+  /// Producer side, returns the number of elements written
+  auto push(const std::span<const T> values) noexcept -> std::size_t {
+    const auto write = tail.load(std::memory_order_relaxed);
+    const auto read = head.load(std::memory_order_acquire);
+    const auto count = std::min(values.size(), capacity() - (write - read));
+
+    copy_in(write, values.first(count));
+    tail.store(write + count, std::memory_order_release);
+
+    return count;
+  }
+
+  /// Consumer side, returns the number of elements read
+  auto pop(const std::span<T> values) noexcept -> std::size_t {
+    const auto read = head.load(std::memory_order_relaxed);
+    const auto write = tail.load(std::memory_order_acquire);
+    const auto count = std::min(values.size(), write - read);
+
+    copy_out(read, values.first(count));
+    head.store(read + count, std::memory_order_release);
+
+    return count;
+  }
+
+private:
+  // Copies in up to two chunks, around the end of the buffer
+  void copy_in(const std::size_t position, const std::span<const T> values) noexcept {
+    const auto start = position & mask;
+    const auto first = std::min(values.size(), capacity() - start);
+
+    std::copy_n(values.begin(), first, buffer.begin() + static_cast<std::ptrdiff_t>(start));
+    std::copy(values.begin() + static_cast<std::ptrdiff_t>(first), values.end(), buffer.begin());
+  }
+
+  void copy_out(const std::size_t position, const std::span<T> values) const noexcept {
+    const auto start = position & mask;
+    const auto first = std::min(values.size(), capacity() - start);
+    const auto begin = buffer.begin() + static_cast<std::ptrdiff_t>(start);
+
+    std::copy_n(begin, first, values.begin());
+    std::copy_n(
+      buffer.begin(),
+      values.size() - first,
+      values.begin() + static_cast<std::ptrdiff_t>(first)
+    );
+  }
+
+  std::vector<T> buffer;
+  std::size_t mask;
+
+  // Free-running positions, on separate cache lines so the two threads don't contend
+  alignas(64) std::atomic<std::size_t> head = 0; // Next element to read
+  alignas(64) std::atomic<std::size_t> tail = 0; // Next element to write
+};
+} // namespace lib
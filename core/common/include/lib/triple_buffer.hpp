@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace lib {
+/// Lock-free triple buffer for exactly one producer thread and one consumer thread.
+/// The producer always has a buffer to write into and the consumer always reads the newest
+/// complete one; neither side ever waits, values the consumer had no time for are skipped.
+template <typename T>
+class TripleBuffer {
+public:
+  TripleBuffer() = default;
+  explicit TripleBuffer(const T& initial) : buffers{initial, initial, initial} {}
+
+  /// Producer side, the buffer being written. The consumer can't see it until publish().
+  [[nodiscard]] auto write_buffer() noexcept -> T& {
+    return buffers[write_index];
+  }
+
+  /// Producer side, makes the written buffer the newest one and moves on to a free buffer
+  void publish() noexcept {
+    write_index = back.exchange(write_index | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+  }
+
+  /// Consumer side, switches to the newest buffer. Returns false if nothing was published since
+  /// the last switch.
+  auto update() noexcept -> bool {
+    if ((back.load(std::memory_order_relaxed) & FRESH) == 0) {
+      return false;
+    }
+
+    read_index = back.exchange(read_index, std::memory_order_acq_rel) & INDEX_MASK;
+    return true;
+  }
+
+  /// Consumer side, stays valid and unchanged until the next update()
+  [[nodiscard]] auto read_buffer() const noexcept -> const T& {
+    return buffers[read_index];
+  }
+
+private:
+  static constexpr std::uint8_t INDEX_MASK = 0x03;
+  static constexpr std::uint8_t FRESH = 0x04; // The back buffer hasn't been read yet
+
+  std::array<T, 3> buffers = {};
+
+  // Each index is owned by one side, the back buffer is swapped with either of them.
+  // On separate cache lines so the two threads don't contend.
+  alignas(64) std::atomic<std::uint8_t> back = 1;
+  alignas(64) std::uint8_t write_index = 0; // Producer only
+  alignas(64) std::uint8_t read_index = 2;  // Consumer only
+};
+} // namespace lib
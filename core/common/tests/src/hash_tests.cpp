@@ -0,0 +1,28 @@
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "lib/hash.hpp"
+
+TEST_CASE("fnv1a matches the reference values", "[test][hash]") {
+  // From the FNV test suite
+  constexpr auto a = std::to_array<std::uint8_t>({'a'});
+  constexpr auto foobar = std::to_array<std::uint8_t>({'f', 'o', 'o', 'b', 'a', 'r'});
+
+  STATIC_REQUIRE(lib::fnv1a({}) == 0xCBF2'9CE4'8422'2325);
+  STATIC_REQUIRE(lib::fnv1a(a) == 0xAF63'DC4C'8601'EC8C);
+  STATIC_REQUIRE(lib::fnv1a(foobar) == 0x8594'4171'F739'67E8);
+}
+
+TEST_CASE("hashing in several parts gives the same hash", "[test][hash]") {
+  constexpr auto bytes = std::to_array<std::uint8_t>({1, 2, 3, 4, 5, 6, 7, 8});
+
+  auto hash = lib::Fnv1a();
+  hash.add(std::span(bytes).first(3));
+  hash.add(bytes[3]);
+  hash.add(std::span(bytes).subspan(4));
+
+  REQUIRE(hash.get() == lib::fnv1a(bytes));
+}
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <numeric>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "lib/spsc_ring.hpp"
+
+TEST_CASE("capacity is rounded up to a power of two", "[test][spsc_ring]") {
+  REQUIRE(lib::SpscRing<int>(1).capacity() == 1);
+  REQUIRE(lib::SpscRing<int>(5).capacity() == 8);
+  REQUIRE(lib::SpscRing<int>(4096).capacity() == 4096);
+}
+
+TEST_CASE("push and pop transfer what fits", "[test][spsc_ring]") {
+  auto ring = lib::SpscRing<int>(4);
+
+  const auto input = std::array{1, 2, 3, 4, 5, 6};
+  REQUIRE(ring.push(input) == 4);
+  REQUIRE(ring.size() == 4);
+  REQUIRE(ring.push(input) == 0);
+
+  auto output = std::array<int, 3>{};
+  REQUIRE(ring.pop(output) == 3);
+  REQUIRE(output == std::array{1, 2, 3});
+
+  // Wraps around the end of the buffer
+  REQUIRE(ring.push(std::span(input).subspan(4)) == 2);
+  REQUIRE(ring.size() == 3);
+
+  auto rest = std::array<int, 8>{};
+  REQUIRE(ring.pop(rest) == 3);
+  REQUIRE(rest[0] == 4);
+  REQUIRE(rest[1] == 5);
+  REQUIRE(rest[2] == 6);
+
+  REQUIRE(ring.pop(rest) == 0);
+}
+
+TEST_CASE("elements arrive in order across threads", "[test][spsc_ring]") {
+  constexpr std::size_t count = 1'000'000;
+
+  auto ring = lib::SpscRing<std::size_t>(1024);
+
+  auto producer = std::thread([&ring] {
+    auto chunk = std::array<std::size_t, 100>{};
+    std::size_t next = 0;
+
+    while (next < count) {
+      std::iota(chunk.begin(), chunk.end(), next);
+      const auto size = std::min(chunk.size(), count - next);
+      next += ring.push(std::span(chunk).first(size));
+    }
+  });
+
+  auto received = std::vector<std::size_t>();
+  received.reserve(count);
+
+  auto chunk = std::array<std::size_t, 64>{};
+
+  while (received.size() < count) {
+    const auto size = ring.pop(chunk);
+    received.insert(
+      received.end(),
+      chunk.begin(),
+      chunk.begin() + static_cast<std::ptrdiff_t>(size)
+    );
+  }
+
+  producer.join();
+
+  auto expected = std::vector<std::size_t>(count);
+  std::iota(expected.begin(), expected.end(), std::size_t{0});
+
+  REQUIRE(received == expected);
+}
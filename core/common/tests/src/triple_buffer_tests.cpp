@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <thread>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "lib/triple_buffer.hpp"
+
+TEST_CASE("the consumer reads the newest published value", "[test][triple_buffer]") {
+  auto buffer = lib::TripleBuffer<int>(-1);
+
+  REQUIRE_FALSE(buffer.update());
+  REQUIRE(buffer.read_buffer() == -1);
+
+  buffer.write_buffer() = 1;
+  buffer.publish();
+
+  REQUIRE(buffer.update());
+  REQUIRE(buffer.read_buffer() == 1);
+  REQUIRE_FALSE(buffer.update());
+
+  // Values the consumer had no time for are skipped
+  for (int value = 2; value <= 5; ++value) {
+    buffer.write_buffer() = value;
+    buffer.publish();
+  }
+
+  REQUIRE(buffer.update());
+  REQUIRE(buffer.read_buffer() == 5);
+  REQUIRE_FALSE(buffer.update());
+  REQUIRE(buffer.read_buffer() == 5);
+}
+
+TEST_CASE("buffers are never shared between the threads", "[test][triple_buffer]") {
+  constexpr std::size_t count = 200'000;
+
+  // Every value fills the whole buffer, a torn read would mix two of them
+  using Values = std::array<std::size_t, 64>;
+  auto buffer = lib::TripleBuffer<Values>();
+
+  auto producer = std::thread([&buffer] {
+    for (std::size_t value = 1; value <= count; ++value) {
+      buffer.write_buffer().fill(value);
+      buffer.publish();
+    }
+  });
+
+  std::size_t last = 0;
+  bool is_torn = false;
+  bool is_out_of_order = false;
+
+  while (last < count) {
+    if (!buffer.update()) {
+      continue;
+    }
+
+    const auto& values = buffer.read_buffer();
+    is_torn |= std::ranges::any_of(values, [&](const auto value) { return value != values[0]; });
+    is_out_of_order |= values[0] <= last;
+    last = values[0];
+  }
+
+  producer.join();
+
+  REQUIRE_FALSE(is_torn);
+  REQUIRE_FALSE(is_out_of_order);
+}
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <print>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "lib/common.hpp"
+#include "nes/constants.hpp"
+#include "nes/nes_batch.hpp"
+
+// Reports the aggregate frames/sec of a NesBatch as the thread count grows
+
+namespace {
+constexpr usize WARMUP_FRAMES = 10;
+
+auto run(
+  const std::filesystem::path& app_path,
+  const std::filesystem::path& rom_path,
+  const usize console_count,
+  const usize frame_count,
+  const usize thread_count
+) -> double {
+  auto batch = nes::NesBatch(console_count, thread_count);
+
+  for (auto& nes : batch.consoles()) {
+    nes.set_app_path(app_path);
+    nes.load(rom_path);
+    nes.power_on();
+  }
+
+  auto frames = std::vector<u32>(console_count * nes::SCREEN_WIDTH * nes::SCREEN_HEIGHT);
+
+  for (usize i = 0; i < WARMUP_FRAMES; ++i) {
+    batch.run_frame(frames);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  for (usize i = 0; i < frame_count; ++i) {
+    batch.run_frame(frames);
+  }
+
+  const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+  return static_cast<double>(console_count * frame_count) / elapsed.count();
+}
+} // namespace
+
+auto main(const int argc, char* argv[]) -> int {
+  const auto args = std::vector<std::string_view>(argv, argv + argc);
+
+  if (args.size() < 2) {
+    std::println(stderr, "Usage: {} <rom> [consoles] [frames]", args[0]);
+    return EXIT_FAILURE;
+  }
+
+  const auto app_path = std::filesystem::path(args[0]).parent_path();
+  const auto rom_path = std::filesystem::path(args[1]);
+  const auto console_count =
+    args.size() > 2 ? static_cast<usize>(std::stoull(std::string(args[2]))) : usize{64};
+  const auto frame_count =
+    args.size() > 3 ? static_cast<usize>(std::stoull(std::string(args[3]))) : usize{60};
+
+  const auto max_threads = std::max(usize{std::thread::hardware_concurrency()}, usize{1});
+
+  auto thread_counts = std::vector<usize>();
+
+  for (usize count = 1; count < max_threads; count *= 2) {
+    thread_counts.push_back(count);
+  }
+
+  thread_counts.push_back(max_threads);
+
+  try {
+    std::println("{} consoles, {} frames each", console_count, frame_count);
+    std::println("{:>8} {:>12} {:>8}", "threads", "frames/s", "speedup");
+
+    double baseline = 0.0;
+
+    for (const auto thread_count : thread_counts) {
+      const auto fps = run(app_path, rom_path, console_count, frame_count, thread_count);
+
+      if (baseline == 0.0) {
+        baseline = fps;
+      }
+
+      std::println("{:>8} {:>12.1f} {:>7.2f}x", thread_count, fps, fps / baseline);
+    }
+  } catch (const std::exception& error) {
+    std::println(stderr, "Error: {}", error.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
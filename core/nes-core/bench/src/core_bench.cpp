@@ -0,0 +1,427 @@
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_session.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "apu.hpp"
+#include "base_mapper.hpp"
+#include "cartridge.hpp"
+#include "controller.hpp"
+#include "cpu.hpp"
+#include "lib/common.hpp"
+#include "nes/nes.hpp"
+#include "ppu.hpp"
+#include "types/cpu_types.hpp"
+#include "utility/ips_patch.hpp"
+#include "utility/rom_image.hpp"
+#include "utility/snapshotable.hpp"
+
+// Micro-benchmarks of the core hot paths and whole frames of the ROMs passed with --rom.
+// Any Catch2 reporter works, e.g. `--reporter JSON::out=results.json` to track them over time.
+
+namespace {
+// Set from the command line in main()
+std::filesystem::path app_path;
+std::vector<std::string> rom_paths;
+
+constexpr usize PRG_BANK_SIZE = 0x4000;
+constexpr usize CHR_BANK_SIZE = 0x2000;
+constexpr u16 PROGRAM_ADDR = 0xC000;
+
+constexpr usize DOTS_PER_FRAME = 341 * 262;
+
+// iNES image with `program` at $C000 (the last 16KB of PRG-ROM at power on, for NROM and MMC3)
+// and CHR-ROM filled with a fixed noise pattern
+auto make_rom(
+  const std::vector<u8>& program,
+  const u8 mapper = 0,
+  const usize prg_banks = 1,
+  const usize chr_banks = 1
+) -> std::vector<u8> {
+  const auto prg_size = prg_banks * PRG_BANK_SIZE;
+
+  auto rom = std::vector<u8>(16 + prg_size + (chr_banks * CHR_BANK_SIZE));
+
+  rom[0] = 'N';
+  rom[1] = 'E';
+  rom[2] = 'S';
+  rom[3] = 0x1A;
+  rom[4] = static_cast<u8>(prg_banks);
+  rom[5] = static_cast<u8>(chr_banks);
+  rom[6] = static_cast<u8>(mapper << 4);
+
+  const auto program_offset = 16 + prg_size - PRG_BANK_SIZE;
+  std::ranges::copy(program, rom.begin() + static_cast<std::ptrdiff_t>(program_offset));
+
+  // Reset vector
+  rom[16 + prg_size - 4] = PROGRAM_ADDR & 0xFF;
+  rom[16 + prg_size - 3] = PROGRAM_ADDR >> 8;
+
+  u32 noise = 0x1234'5678;
+
+  for (auto i = 16 + prg_size; i < rom.size(); ++i) {
+    noise = (noise * 1'664'525) + 1'013'904'223;
+    rom[i] = static_cast<u8>(noise >> 24);
+  }
+
+  return rom;
+}
+
+//
+// CPU programs
+//
+
+// clang-format off
+constexpr auto PROLOGUE = std::to_array<u8>({
+  0x78,       // SEI
+  0xD8,       // CLD
+  0xA2, 0xFF, // LDX #$FF
+  0x9A,       // TXS
+  0xA9, 0x00, // LDA #$00
+  0x85, 0x10, // STA $10    ; ($10),Y -> $0300
+  0x85, 0x14, // STA $14    ; ($10,X) -> $0300
+  0xA9, 0x03, // LDA #$03
+  0x85, 0x11, // STA $11
+  0x85, 0x15, // STA $15
+  0xA2, 0x04, // LDX #$04
+  0xA0, 0x08, // LDY #$08
+});
+// clang-format on
+
+constexpr usize LOOP_REPEATS = 8;
+
+// The prologue, a pointer to the loop at $16 for JMP ($0016), then `body` repeated and a jump
+// back. Rendering and NMIs are left disabled, so the CPU dominates the frame.
+auto make_program(const std::vector<u8>& body) -> std::vector<u8> {
+  constexpr usize pointer_setup_size = 8;
+  constexpr auto loop_addr = static_cast<u16>(PROGRAM_ADDR + PROLOGUE.size() + pointer_setup_size);
+
+  auto program = std::vector<u8>(PROLOGUE.begin(), PROLOGUE.end());
+
+  const auto loop_lo = static_cast<u8>(loop_addr & 0xFF);
+  const auto loop_hi = static_cast<u8>(loop_addr >> 8);
+
+  // LDA #lo, STA $16, LDA #hi, STA $17
+  program.insert(program.end(), {0xA9, loop_lo, 0x85, 0x16, 0xA9, loop_hi, 0x85, 0x17});
+
+  for (usize i = 0; i < LOOP_REPEATS; ++i) {
+    program.insert(program.end(), body.begin(), body.end());
+  }
+
+  // JMP loop
+  program.insert(program.end(), {0x4C, loop_lo, loop_hi});
+
+  return program;
+}
+
+struct AddressingMode {
+  const char* name;
+  std::vector<u8> body;
+};
+
+auto get_addressing_modes() -> std::vector<AddressingMode> {
+  return {
+    {.name = "implied", .body = {0xE8}},                   // INX
+    {.name = "accumulator", .body = {0x0A}},               // ASL A
+    {.name = "immediate", .body = {0xA9, 0x42}},           // LDA #$42
+    {.name = "zero page", .body = {0xA5, 0x20}},           // LDA $20
+    {.name = "zero page,X", .body = {0xB5, 0x20}},         // LDA $20,X
+    {.name = "zero page,Y", .body = {0xB6, 0x20}},         // LDX $20,Y
+    {.name = "absolute", .body = {0xAD, 0x00, 0x03}},      // LDA $0300
+    {.name = "absolute,X", .body = {0xBD, 0x00, 0x03}},    // LDA $0300,X
+    {.name = "absolute,Y", .body = {0xB9, 0x00, 0x03}},    // LDA $0300,Y
+    {.name = "(indirect,X)", .body = {0xA1, 0x10}},        // LDA ($10,X)
+    {.name = "(indirect),Y", .body = {0xB1, 0x10}},        // LDA ($10),Y
+    {.name = "relative", .body = {0xD0, 0x00}},            // BNE *+2 (taken)
+    {.name = "indirect", .body = {0x6C, 0x16, 0x00}},      // JMP ($0016), only the first runs
+    {.name = "absolute (RMW)", .body = {0xEE, 0x00, 0x03}} // INC $0300
+  };
+}
+
+//
+// Console
+//
+
+// The components wired together like nes::Nes does, so each of them can be driven directly
+struct Console {
+  explicit Console(const std::vector<u8>& rom) {
+    cpu.irq = irq;
+    cpu.nmi = nmi;
+    ppu.nmi = nmi;
+
+    cartridge.load(nes::utility::RomImage(rom), std::nullopt, irq);
+    ppu.set_palette(std::vector<u8>(64 * 3));
+
+    apu.power_on();
+    cpu.power_on();
+    ppu.power_on();
+  }
+
+  nes::Cartridge cartridge;
+  nes::Controller controller;
+  nes::Ppu ppu{cartridge};
+  nes::Apu apu{cartridge};
+  nes::Cpu cpu{ppu, apu, cartridge, controller};
+
+  std::shared_ptr<bool> irq = std::make_shared<bool>(false);
+  std::shared_ptr<bool> nmi = std::make_shared<bool>(false);
+};
+
+// Fills the nametable and the palettes, places `sprite_count` sprites spread over the screen and
+// turns rendering on
+void setup_rendering(nes::Ppu& ppu, const usize sprite_count) {
+  ppu.write(0x2006, 0x20);
+  ppu.write(0x2006, 0x00);
+
+  for (usize i = 0; i < 0x400; ++i) {
+    ppu.write(0x2007, static_cast<u8>(i * 7));
+  }
+
+  ppu.write(0x2006, 0x3F);
+  ppu.write(0x2006, 0x00);
+
+  for (usize i = 0; i < 0x20; ++i) {
+    ppu.write(0x2007, static_cast<u8>(i + 1));
+  }
+
+  // Every scanline has 2 or 3 sprites on it with 64 of them
+  ppu.write(0x2003, 0x00);
+
+  for (usize i = 0; i < 64; ++i) {
+    const auto is_visible = i < sprite_count;
+
+    ppu.write(0x2004, is_visible ? static_cast<u8>((i * 29) % 232) : 0xFF); // Y
+    ppu.write(0x2004, static_cast<u8>(i));                                  // Tile
+    ppu.write(0x2004, static_cast<u8>(i & 0xC3));                           // Attributes
+    ppu.write(0x2004, static_cast<u8>(i * 37));                             // X
+  }
+
+  ppu.write(0x2006, 0x00);
+  ppu.write(0x2006, 0x00);
+  ppu.write(0x2001, sprite_count > 0 ? 0x1E : 0x0A);
+}
+
+void snapshot_round_trip(nes::utility::Snapshotable& component, std::vector<u8>& buffer) {
+  buffer.clear();
+
+  auto out = nes::utility::SnapshotWriter(buffer);
+  component.save(out);
+
+  auto in = nes::utility::SnapshotReader(buffer);
+  component.load(in);
+}
+
+// "PATCH", `count` 16-byte records and as many RLE ones spread over `size` bytes, "EOF"
+auto make_ips_patch(const usize size, const usize count) -> std::vector<u8> {
+  auto patch = std::vector<u8>{'P', 'A', 'T', 'C', 'H'};
+
+  const auto stride = size / count;
+
+  for (usize i = 0; i < count; ++i) {
+    const auto addr = i * stride;
+    const auto rle_addr = addr + (stride / 2);
+
+    patch.insert(
+      patch.end(), {static_cast<u8>(addr >> 16), static_cast<u8>(addr >> 8), static_cast<u8>(addr)}
+    );
+    patch.insert(patch.end(), {0x00, 0x10});
+
+    for (usize j = 0; j < 0x10; ++j) {
+      patch.push_back(static_cast<u8>(i + j));
+    }
+
+    patch.insert(
+      patch.end(),
+      {static_cast<u8>(rle_addr >> 16), static_cast<u8>(rle_addr >> 8), static_cast<u8>(rle_addr)}
+    );
+    patch.insert(patch.end(), {0x00, 0x00, 0x00, 0x20, static_cast<u8>(i)});
+  }
+
+  patch.insert(patch.end(), {'E', 'O', 'F'});
+
+  return patch;
+}
+} // namespace
+
+TEST_CASE("Cpu::execute", "[cpu]") {
+  for (const auto& [name, body] : get_addressing_modes()) {
+    auto console = Console(make_rom(make_program(body)));
+    console.cpu.run_frame();
+
+    BENCHMARK(std::format("Cpu::execute, {} (frame)", name)) {
+      console.cpu.run_frame();
+    };
+  }
+}
+
+TEST_CASE("types::cpu::memory::get_map", "[cpu]") {
+  using nes::types::cpu::memory::get_map;
+  using nes::types::cpu::memory::Operation;
+
+  const auto sum_map = [](auto get) {
+    usize sum = 0;
+
+    for (u32 addr = 0; addr <= 0xFFFF; ++addr) {
+      sum += static_cast<usize>(get(static_cast<u16>(addr)));
+    }
+
+    return sum;
+  };
+
+  BENCHMARK("get_map<Read>, 64KB") {
+    return sum_map(get_map<Operation::Read>);
+  };
+
+  BENCHMARK("get_map<Write>, 64KB") {
+    return sum_map(get_map<Operation::Write>);
+  };
+}
+
+// Ppu::sprite_evaluation is private, its cost (with the sprite fetches and the compositing) is
+// the difference between the frames with and without sprites
+TEST_CASE("Ppu::step", "[ppu]") {
+  for (const usize sprite_count : {usize{0}, usize{64}}) {
+    auto console = Console(make_rom(make_program({0xEA}))); // NOP
+    setup_rendering(console.ppu, sprite_count);
+
+    for (usize dot = 0; dot < DOTS_PER_FRAME; ++dot) {
+      console.ppu.step();
+    }
+
+    BENCHMARK(std::format("Ppu::step, {} sprites (frame)", sprite_count)) {
+      for (usize dot = 0; dot < DOTS_PER_FRAME; ++dot) {
+        console.ppu.step();
+      }
+    };
+  }
+}
+
+TEST_CASE("BaseMapper", "[mapper]") {
+  // MMC3 with 64KB PRG-ROM and 64KB CHR-ROM, banks as set at power on
+  auto console = Console(make_rom(make_program({0xEA}), 4, 4, 8));
+  const auto* mapper = console.cartridge.get_mapper();
+
+  BENCHMARK("BaseMapper::get_prg_addr, 32KB") {
+    usize sum = 0;
+
+    for (u32 addr = 0x8000; addr <= 0xFFFF; ++addr) {
+      sum += mapper->get_prg_addr(static_cast<u16>(addr));
+    }
+
+    return sum;
+  };
+
+  BENCHMARK("BaseMapper::get_chr_addr, 8KB") {
+    usize sum = 0;
+
+    for (u32 addr = 0x0000; addr < 0x2000; ++addr) {
+      sum += mapper->get_chr_addr(static_cast<u16>(addr));
+    }
+
+    return sum;
+  };
+}
+
+TEST_CASE("IpsPatch::patch", "[utility]") {
+  constexpr usize rom_size = usize{512} * 1024;
+
+  const auto rom = std::vector<u8>(rom_size, 0xFF);
+  const auto patch = nes::utility::IpsPatch(make_ips_patch(rom_size, 1024));
+
+  // Includes copying the ROM, which a mapped file would only do for the touched pages
+  BENCHMARK("IpsPatch::patch, 512KB and 2048 records") {
+    auto image = nes::utility::RomImage(rom);
+    patch.patch(image);
+    return image.size();
+  };
+}
+
+TEST_CASE("Snapshotable", "[snapshot]") {
+  auto console = Console(make_rom(make_program({0xEA}), 4, 4, 8));
+  setup_rendering(console.ppu, 64);
+  console.cpu.run_frame();
+
+  auto buffer = std::vector<u8>();
+
+  BENCHMARK("Cpu save + load") {
+    snapshot_round_trip(console.cpu, buffer);
+  };
+
+  BENCHMARK("Ppu save + load") {
+    snapshot_round_trip(console.ppu, buffer);
+  };
+
+  BENCHMARK("Apu save + load") {
+    snapshot_round_trip(console.apu, buffer);
+  };
+
+  BENCHMARK("Cartridge save + load") {
+    snapshot_round_trip(console.cartridge, buffer);
+  };
+}
+
+TEST_CASE("Nes::run_frame", "[frame]") {
+  // Synthesized, so there is always a whole frame to measure: NROM rendering 64 sprites while
+  // the CPU runs a loop
+  {
+    auto console = Console(make_rom(make_program({0xA5, 0x20, 0xE8}))); // LDA $20, INX
+    setup_rendering(console.ppu, 64);
+    console.cpu.run_frame();
+
+    BENCHMARK("Cpu::run_frame, synthesized NROM") {
+      console.cpu.run_frame();
+    };
+  }
+
+  for (const auto& rom_path : rom_paths) {
+    auto nes = nes::Nes();
+    nes.set_app_path(app_path);
+    nes.load(rom_path);
+    nes.power_on();
+
+    for (usize i = 0; i < 60; ++i) {
+      nes.run_frame();
+    }
+
+    const auto name = std::filesystem::path(rom_path).filename().string();
+    auto state = std::vector<u8>();
+
+    BENCHMARK(std::format("Nes::run_frame, {}", name)) {
+      nes.run_frame();
+      return nes.get_frame_buffer();
+    };
+
+    BENCHMARK(std::format("Nes::save_state + load_state, {}", name)) {
+      nes.save_state(state);
+      nes.load_state(state);
+    };
+  }
+}
+
+auto main(const int argc, char* argv[]) -> int {
+  auto session = Catch::Session();
+
+  using Catch::Clara::Opt;
+
+  const auto cli = session.cli() |
+                   Opt(rom_paths, "rom")["--rom"]("ROM measured by the whole frame benchmarks");
+
+  session.cli(cli);
+
+  if (const auto result = session.applyCommandLine(argc, argv); result != 0) {
+    return result;
+  }
+
+  app_path = std::filesystem::path(argv[0]).parent_path();
+
+  return session.run();
+}
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "apu.hpp"
+#include "cartridge.hpp"
+#include "controller.hpp"
+#include "cpu.hpp"
+#include "lib/common.hpp"
+#include "ppu.hpp"
+#include "types/cpu_types.hpp"
+#include "utility/rom_image.hpp"
+
+// Reports the instructions/sec of each CPU dispatch backend on a CPU-bound loop
+
+namespace {
+constexpr usize WARMUP_FRAMES = 10;
+constexpr usize CYCLES_PER_FRAME = 29781;
+
+// The loop runs 14 instructions in 42 cycles, with rendering and NMIs disabled
+constexpr usize INSTRUCTIONS_PER_LOOP = 14;
+constexpr usize CYCLES_PER_LOOP = 42;
+
+// clang-format off
+constexpr auto PROGRAM = std::to_array<u8>({
+  0x78,             // SEI
+  0xD8,             // CLD
+  0xA2, 0xFF,       // LDX #$FF
+  0x9A,             // TXS
+  0xA9, 0x00,       // LDA #$00
+  0x8D, 0x00, 0x20, // STA $2000
+  0x8D, 0x01, 0x20, // STA $2001
+  // loop ($C00D)
+  0xB5, 0x10,       // LDA $10,X
+  0x18,             // CLC
+  0x69, 0x03,       // ADC #$03
+  0x95, 0x10,       // STA $10,X
+  0x4D, 0x00, 0x02, // EOR $0200
+  0x8D, 0x00, 0x02, // STA $0200
+  0xA4, 0x11,       // LDY $11
+  0xC8,             // INY
+  0x84, 0x11,       // STY $11
+  0x98,             // TYA
+  0x29, 0x0F,       // AND #$0F
+  0xAA,             // TAX
+  0x06, 0x12,       // ASL $12
+  0x4C, 0x0D, 0xC0, // JMP loop
+});
+// clang-format on
+
+auto make_rom() -> std::vector<u8> {
+  constexpr usize prg_size = 0x4000;
+
+  auto rom = std::vector<u8>(16 + prg_size + 0x2000);
+
+  // iNES header: NROM, 16KB PRG-ROM, 8KB CHR-ROM
+  rom[0] = 'N';
+  rom[1] = 'E';
+  rom[2] = 'S';
+  rom[3] = 0x1A;
+  rom[4] = 1;
+  rom[5] = 1;
+
+  std::ranges::copy(PROGRAM, rom.begin() + 16);
+
+  // Reset vector ($C000)
+  rom[16 + prg_size - 4] = 0x00;
+  rom[16 + prg_size - 3] = 0xC0;
+
+  return rom;
+}
+
+auto run(const std::vector<u8>& rom, const nes::types::cpu::Dispatch dispatch, const usize frames)
+  -> double {
+  auto cartridge = nes::Cartridge();
+  auto controller = nes::Controller();
+  auto ppu = nes::Ppu(cartridge);
+  auto apu = nes::Apu(cartridge);
+  auto cpu = nes::Cpu(ppu, apu, cartridge, controller);
+
+  const auto irq = std::make_shared<bool>(false);
+  const auto nmi = std::make_shared<bool>(false);
+  cpu.irq = irq;
+  cpu.nmi = nmi;
+  ppu.nmi = nmi;
+
+  cartridge.load(nes::utility::RomImage(rom), std::nullopt, irq);
+  ppu.set_palette(std::vector<u8>(64 * 3));
+
+  cpu.set_dispatch(dispatch);
+  apu.power_on();
+  cpu.power_on();
+  ppu.power_on();
+
+  for (usize i = 0; i < WARMUP_FRAMES; ++i) {
+    cpu.run_frame();
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  for (usize i = 0; i < frames; ++i) {
+    cpu.run_frame();
+  }
+
+  const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+  const auto instructions =
+    static_cast<double>(frames * CYCLES_PER_FRAME * INSTRUCTIONS_PER_LOOP) / CYCLES_PER_LOOP;
+
+  return instructions / elapsed.count();
+}
+} // namespace
+
+auto main(const int argc, char* argv[]) -> int {
+  const auto args = std::vector<std::string_view>(argv, argv + argc);
+
+  const auto frames = args.size() > 1 ? static_cast<usize>(std::stoull(std::string(args[1])))
+                                      : usize{600};
+
+  const auto rom = make_rom();
+
+  const auto switch_ips = run(rom, nes::types::cpu::Dispatch::Switch, frames);
+  const auto table_ips = run(rom, nes::types::cpu::Dispatch::Table, frames);
+
+  std::println("{} frames", frames);
+  std::println("{:>8} {:>16}", "dispatch", "instructions/s");
+  std::println("{:>8} {:>16.0f}", "switch", switch_ips);
+  std::println(
+    "{:>8} {:>16.0f} ({:+.1f}%)",
+    "table",
+    table_ips,
+    (table_ips / switch_ips - 1) * 100
+  );
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lib/common.hpp"
+#include "nes/nes.hpp"
+#include "nes/run_ahead.hpp"
+
+// Reports the host frame time with each run-ahead setting, and what every extra frame costs
+
+namespace {
+constexpr usize WARMUP_FRAMES = 10;
+
+// Milliseconds per host frame, `run_ahead` frames ahead (none if empty)
+auto run(
+  const std::filesystem::path& app_path,
+  const std::filesystem::path& rom_path,
+  const usize frame_count,
+  const std::optional<usize> run_ahead_frames
+) -> double {
+  auto nes = nes::Nes();
+  nes.set_app_path(app_path);
+  nes.load(rom_path);
+  nes.power_on();
+
+  auto run_ahead = nes::RunAhead(run_ahead_frames.value_or(nes::RunAhead::MIN_FRAMES));
+
+  const auto run_frame = [&](const usize frame) {
+    nes.update_controller_state(0, static_cast<u8>(frame >> 4));
+
+    if (run_ahead_frames) {
+      run_ahead.run_frame(nes);
+    } else {
+      nes.run_frame();
+    }
+
+    UNUSED(nes.get_frame_buffer());
+  };
+
+  for (usize i = 0; i < WARMUP_FRAMES; ++i) {
+    run_frame(i);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  for (usize i = 0; i < frame_count; ++i) {
+    run_frame(i);
+  }
+
+  const auto elapsed =
+    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+  return elapsed.count() / static_cast<double>(frame_count);
+}
+} // namespace
+
+auto main(const int argc, char* argv[]) -> int {
+  const auto args = std::vector<std::string_view>(argv, argv + argc);
+
+  if (args.size() < 2) {
+    std::println(stderr, "Usage: {} <rom> [frames]", args[0]);
+    return EXIT_FAILURE;
+  }
+
+  const auto app_path = std::filesystem::path(args[0]).parent_path();
+  const auto rom_path = std::filesystem::path(args[1]);
+  const auto frame_count =
+    args.size() > 2 ? static_cast<usize>(std::stoull(std::string(args[2]))) : usize{600};
+
+  try {
+    const auto baseline = run(app_path, rom_path, frame_count, std::nullopt);
+
+    std::println("{} frames", frame_count);
+    std::println(
+      "{:>9} {:>12} {:>12} {:>16}",
+      "run-ahead",
+      "ms/frame",
+      "overhead",
+      "ms/extra frame"
+    );
+    std::println("{:>9} {:>12.3f}", "off", baseline);
+
+    for (auto frames = nes::RunAhead::MIN_FRAMES; frames <= nes::RunAhead::MAX_FRAMES; ++frames) {
+      const auto time = run(app_path, rom_path, frame_count, frames);
+
+      std::println(
+        "{:>9} {:>12.3f} {:>11.1f}% {:>16.3f}",
+        frames,
+        time,
+        (time / baseline - 1) * 100,
+        (time - baseline) / static_cast<double>(frames)
+      );
+    }
+  } catch (const std::exception& error) {
+    std::println(stderr, "Error: {}", error.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
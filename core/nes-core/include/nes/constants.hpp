@@ -9,5 +9,7 @@ inline constexpr u32 SCREEN_WIDTH = 256;
 inline constexpr u32 SCREEN_HEIGHT = 240;
 inline constexpr u32 FRAMEBUFFER_SIZE = (SCREEN_WIDTH * SCREEN_HEIGHT) * sizeof(u32);
 
+inline constexpr u32 AUDIO_SAMPLE_RATE = 48000; // Mono
+
 inline constexpr auto TITLE = std::string_view("nes-emulator");
 } // namespace nes
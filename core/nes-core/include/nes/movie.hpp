@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "lib/common.hpp"
+#include "nes/nes.hpp"
+
+namespace nes {
+// The controller states of every frame and the reset and power events of a run, replayed
+// exactly through Nes::run_frame(). A movie starts at power on or from a savestate and is tied
+// to the ROM it was recorded with; it may also hold hashes of the CPU RAM and of the picture
+// after every frame, to tell where a replay stops matching the recording.
+//
+// Movies starting at power on also depend on the battery save (PRG-RAM) of the ROM, if any.
+class Movie {
+public:
+  enum class Event : u8 {
+    None,
+    Reset,
+    PowerOn,
+  };
+
+  struct Input {
+    std::array<u8, 2> state = {}; // Controller ports
+    Event event = Event::None;    // Applied before the frame
+  };
+
+  struct Hashes {
+    u64 ram = 0;   // CPU RAM
+    u64 frame = 0; // Palette indices and colour emphasis of the frame
+
+    [[nodiscard]] auto operator==(const Hashes&) const -> bool = default;
+  };
+
+  [[nodiscard]] static auto get_hashes(const Nes& nes) -> Hashes;
+
+  [[nodiscard]] static auto load(const std::filesystem::path& path) -> Movie;
+  void save(const std::filesystem::path& path) const;
+
+  // Inputs are run-length encoded, the hashes are stored as is
+  [[nodiscard]] static auto deserialize(std::span<const u8> data) -> Movie;
+  [[nodiscard]] auto serialize() const -> std::vector<u8>;
+
+  [[nodiscard]] auto get_rom_hash() const -> u64;
+  [[nodiscard]] auto get_start_state() const -> std::span<const u8>; // Empty: power on
+
+  [[nodiscard]] auto size() const -> usize; // Frames
+  [[nodiscard]] auto get_input(usize frame) const -> Input;
+
+  [[nodiscard]] auto has_hashes() const -> bool;
+  [[nodiscard]] auto get_hashes(usize frame) const -> Hashes;
+
+private:
+  friend class MovieRecorder;
+
+  u64 rom_hash = 0;
+  std::vector<u8> start_state;
+
+  std::vector<Input> inputs;
+  std::vector<Hashes> hashes; // One per frame, or empty
+};
+
+// Runs the console and records what it is given into a movie
+class MovieRecorder {
+public:
+  enum class Start {
+    PowerOn,   // Powers on the console
+    Savestate, // Starts from the current state of the console
+  };
+
+  explicit MovieRecorder(Nes& nes, Start start = Start::PowerOn, bool record_hashes = true);
+
+  // Replace Nes::reset() and Nes::power_on(), the event is recorded with the next frame.
+  // There can be one of them per frame.
+  void reset(Nes& nes);
+  void power_on(Nes& nes);
+
+  // Replaces Nes::update_controller_state() and Nes::run_frame()
+  void run_frame(Nes& nes, std::array<u8, 2> state);
+
+  [[nodiscard]] auto get_movie() const -> const Movie&;
+
+private:
+  void add_event(Movie::Event event);
+
+  Movie movie;
+  Movie::Event pending_event = Movie::Event::None;
+  bool record_hashes;
+};
+
+// Replays a movie, checking the ROM before starting and the hashes (if any) after every frame.
+// Mismatches throw std::runtime_error.
+class MoviePlayer {
+public:
+  // Powers on the console or loads the starting savestate
+  MoviePlayer(Movie movie, Nes& nes);
+
+  [[nodiscard]] auto is_done() const -> bool;
+  [[nodiscard]] auto get_frame() const -> usize; // Frames played so far
+  [[nodiscard]] auto get_movie() const -> const Movie&;
+
+  // Replaces Nes::run_frame(), does nothing once the movie is done
+  void run_frame(Nes& nes);
+
+private:
+  Movie movie;
+  usize frame = 0;
+};
+} // namespace nes
@@ -1,12 +1,34 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
 
 #include "lib/common.hpp"
 
 namespace nes {
+class Apu;
+class Cartridge;
+class Controller;
+class Cpu;
+class Ppu;
+
+namespace utility {
+  class FileManager;
+  class SnapshotReader;
+} // namespace utility
+
 class Nes {
 public:
+  Nes();
+  ~Nes();
+
+  Nes(const Nes&) = delete;
+  auto operator=(const Nes&) -> Nes& = delete;
+  Nes(Nes&&) noexcept;
+  auto operator=(Nes&&) noexcept -> Nes&;
+
   void set_app_path(const std::filesystem::path& path);
   void load(const std::filesystem::path& path);
   void reset();
@@ -14,8 +36,57 @@ public:
   void power_off();
 
   void run_frame();
+
+  // RGB colours of the last frame, converted from the palette indices on demand
   auto get_frame_buffer() -> const u32*;
 
+  // Palette indices (0x00-0x3F) of the last frame and its PPUMASK colour emphasis (0-7), for
+  // consumers that don't need RGB
+  [[nodiscard]] auto get_frame_indices() const -> std::span<const u8>;
+  [[nodiscard]] auto get_frame_emphasis() const -> u8;
+
   void update_controller_state(usize port, u8 state);
+
+  // Internal RAM of the CPU ($0000-$07FF)
+  [[nodiscard]] auto get_cpu_ram() const -> std::span<const u8>;
+
+  // FNV-1a of the ROM image loaded by the last power_on(), after patching. Computed on each
+  // call, as it reads the whole ROM.
+  [[nodiscard]] auto get_rom_hash() const -> u64;
+
+  // Frames run without output aren't drawn, which makes them cheaper; the emulation itself
+  // is unchanged. Meant for frames that are never shown (e.g. run-ahead).
+  void set_output_enabled(bool enabled);
+
+  // Whether a frame followed by `frames_left` more before the picture is shown needs output.
+  // A picture is usually drawn across two calls to run_frame(), which runs a fixed number of
+  // CPU cycles, so only the frames before the last two can run without it.
+  [[nodiscard]] static auto needs_output(usize frames_left) -> bool;
+
+  // Audio is only synthesized when enabled (off by default). The samples of the frames run so
+  // far are mono at AUDIO_SAMPLE_RATE; when nobody reads them only the latest are kept.
+  void set_audio_enabled(bool enabled);
+  [[nodiscard]] auto is_audio_enabled() const -> bool;
+  auto read_audio_samples(std::span<float> samples) -> usize; // Returns the number written
+
+  // In-memory savestates of the whole console, meant to be taken between frames.
+  // `state` is cleared and refilled, so reusing the same vector avoids allocations.
+  // Loading throws std::runtime_error on an invalid state and leaves the console as it was.
+  void save_state(std::vector<u8>& state) const;
+  [[nodiscard]] auto save_state() const -> std::vector<u8>;
+  void load_state(std::span<const u8> state);
+
+private:
+  void load_components(utility::SnapshotReader& in);
+
+  // Each console owns all of its components, so several of them can run side by side
+  std::unique_ptr<utility::FileManager> file_manager;
+  std::unique_ptr<Cartridge> cartridge;
+  std::unique_ptr<Controller> controller;
+  std::unique_ptr<Ppu> ppu;
+  std::unique_ptr<Apu> apu;
+  std::unique_ptr<Cpu> cpu;
+
+  std::vector<u8> load_backup; // Restored when load_state() fails half-way through
 };
 } // namespace nes
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "lib/common.hpp"
+#include "nes/nes.hpp"
+
+namespace nes {
+namespace utility {
+  class ThreadPool;
+} // namespace utility
+
+// Steps many independent consoles in parallel
+class NesBatch {
+public:
+  // A `thread_count` of zero uses one thread per hardware core
+  explicit NesBatch(usize size, usize thread_count = 0);
+  ~NesBatch();
+
+  NesBatch(const NesBatch&) = delete;
+  auto operator=(const NesBatch&) -> NesBatch& = delete;
+  NesBatch(NesBatch&&) noexcept;
+  auto operator=(NesBatch&&) noexcept -> NesBatch&;
+
+  [[nodiscard]] auto size() const -> usize;
+  [[nodiscard]] auto thread_count() const -> usize;
+
+  // Consoles are set up (ROM, palette, controllers) through the regular Nes API
+  [[nodiscard]] auto get(usize index) -> Nes&;
+  [[nodiscard]] auto consoles() -> std::span<Nes>;
+
+  void run_frame();
+
+  // Runs one frame on every console and copies the frame buffers into `frames`,
+  // which is laid out as [size()][SCREEN_HEIGHT][SCREEN_WIDTH]
+  void run_frame(std::span<u32> frames);
+
+  // Same as above with the palette indices, without any RGB conversion
+  void run_frame(std::span<u8> frames);
+
+private:
+  void check_frames_size(usize size) const;
+
+  std::vector<Nes> nes_list;
+  std::unique_ptr<utility::ThreadPool> thread_pool;
+};
+} // namespace nes
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "lib/common.hpp"
+#include "nes/nes.hpp"
+
+namespace nes::netplay {
+// Controller state of one peer for one frame
+struct InputPacket {
+  u32 frame = 0;
+  u8 input = 0;
+};
+
+// Carries the inputs of one peer to the other. Packets may arrive late or out of order.
+class Transport {
+public:
+  Transport() = default;
+  virtual ~Transport() = default;
+
+  Transport(const Transport&) = delete;
+  Transport(Transport&&) = default;
+  auto operator=(const Transport&) -> Transport& = delete;
+  auto operator=(Transport&&) -> Transport& = default;
+
+  virtual void send(const InputPacket& packet) = 0;
+  [[nodiscard]] virtual auto receive() -> std::optional<InputPacket> = 0; // Empty if none arrived
+};
+
+// Both ends in the same process, with simulated latency, to test netplay on a single machine.
+// Each packet is delivered after `delay` plus a random jitter in [0, `jitter`].
+class LoopbackTransport final: public Transport {
+public:
+  struct Settings {
+    std::chrono::microseconds delay{0};
+    std::chrono::microseconds jitter{0};
+    u32 seed = 0;
+  };
+
+  [[nodiscard]] static auto make_pair(const Settings& settings)
+    -> std::pair<LoopbackTransport, LoopbackTransport>;
+
+  void send(const InputPacket& packet) override;
+  [[nodiscard]] auto receive() -> std::optional<InputPacket> override;
+
+private:
+  struct Queue;
+
+  LoopbackTransport(
+    std::shared_ptr<Queue> inbox_ptr,
+    std::shared_ptr<Queue> outbox_ptr,
+    const Settings& settings_ref,
+    u32 seed
+  );
+
+  std::shared_ptr<Queue> inbox;
+  std::shared_ptr<Queue> outbox;
+  Settings settings;
+  std::mt19937 rng;
+};
+
+// Rollback netplay for two players. The local player is on `local_port` and the remote one on
+// the other port. Frames run right away with a prediction of the remote input (its last known
+// value); when the real input arrives and differs, the console goes back to that frame and runs
+// again up to the present, without drawing the frames that are never shown.
+class Session {
+public:
+  struct Stats {
+    usize rollbacks = 0;
+    usize resimulated_frames = 0;
+    std::chrono::microseconds max_rollback_time{0};
+  };
+
+  Session(Nes& nes_ref, Transport& transport_ref, usize local_port, usize max_rollback = 8);
+
+  // Runs the next frame with the local input. Returns false without running it when the
+  // remote input is more than `max_rollback` frames late, the caller should try again later.
+  auto advance_frame(u8 local_input) -> bool;
+
+  // Applies the remote inputs received so far, rolling back if a prediction was wrong
+  void poll();
+
+  [[nodiscard]] auto get_frame() const -> u32;           // Frames run so far
+  [[nodiscard]] auto get_confirmed_frame() const -> u32; // Frames whose remote input is known
+  [[nodiscard]] auto get_stats() const -> const Stats&;
+
+private:
+  struct FrameData {
+    std::vector<u8> state; // Savestate at the start of the frame
+    u8 local_input = 0;
+    u8 remote_input = 0; // Confirmed or predicted
+  };
+
+  struct RemoteInput {
+    u32 frame = 0;
+    u8 input = 0;
+    bool is_valid = false;
+  };
+
+  [[nodiscard]] auto get_frame_data(u32 frame_index) -> FrameData&;
+  [[nodiscard]] auto get_remote_input(u32 frame_index) -> RemoteInput&;
+  [[nodiscard]] auto predict_remote_input(u32 frame_index) -> u8;
+
+  void run_frame(u32 frame_index);
+  void rollback(u32 from_frame);
+
+  Nes* nes;
+  Transport* transport;
+
+  usize local_port;
+  usize remote_port;
+  usize max_rollback;
+
+  std::vector<FrameData> history;         // Ring of the last `max_rollback` + 1 frames
+  std::vector<RemoteInput> remote_inputs; // Ring, the remote peer may be ahead
+
+  u32 frame = 0;
+  u32 confirmed_frame = 0;
+
+  Stats stats;
+};
+} // namespace nes::netplay
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <deque>
+#include <span>
+#include <vector>
+
+#include "lib/common.hpp"
+#include "nes/nes.hpp"
+
+namespace nes {
+// History of savestates for rewinding, kept within a fixed memory budget.
+// Every `interval` frames a state is stored, XORed against the last keyframe and run-length
+// encoded; a new keyframe is stored every `keyframe_interval` states. The oldest keyframes are
+// dropped along with their deltas when the budget is exceeded.
+class Rewind {
+public:
+  explicit Rewind(usize memory_budget, usize interval = 1, usize keyframe_interval = 60);
+
+  // Called once per frame, after Nes::run_frame()
+  void push(const Nes& nes);
+  void push(std::span<const u8> nes_state); // State from Nes::save_state()
+
+  // Restores the most recent state and drops it from the history.
+  // Returns false if there is nothing left to go back to.
+  auto step_back(Nes& nes) -> bool;
+
+  void clear();
+
+  // Number of states in the history
+  [[nodiscard]] auto size() const -> usize;
+
+  // Bytes used by the compressed states
+  [[nodiscard]] auto memory_usage() const -> usize;
+
+  // Average bytes per minute of history at 60 frames per second
+  [[nodiscard]] auto memory_per_minute() const -> usize;
+
+private:
+  struct Entry {
+    bool is_keyframe;
+    std::vector<u8> data;
+  };
+
+  void evict();
+  void decode_last_keyframe();
+
+  usize memory_budget;
+  usize interval;
+  usize keyframe_interval;
+
+  std::deque<Entry> entries;
+  usize used = 0;
+  usize frame_count = 0;
+  usize deltas_since_keyframe = 0;
+
+  // Decoded copy of the newest keyframe, base of the deltas after it
+  std::vector<u8> keyframe;
+  // Reused for saving and decoding states
+  std::vector<u8> state;
+};
+} // namespace nes
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "lib/common.hpp"
+#include "nes/nes.hpp"
+
+namespace nes {
+// Hides the input lag of games that react a few frames late: every frame the console runs
+// ahead by `frames` frames with the current input, the last one is shown, and the console goes
+// back to its real state at the start of the next frame.
+class RunAhead {
+public:
+  static constexpr usize MIN_FRAMES = 1;
+  static constexpr usize MAX_FRAMES = 4;
+
+  explicit RunAhead(usize frames = 1);
+
+  [[nodiscard]] auto get_frames() const -> usize;
+  void set_frames(usize frames);
+
+  // Replaces Nes::run_frame(). Afterwards the console is in the run-ahead state, showing the
+  // frame that is `frames` frames ahead.
+  void run_frame(Nes& nes);
+
+  // Puts the console back in its real state. Needed before using it other than through
+  // run_frame() (reset, power off, ...).
+  void restore(Nes& nes);
+
+  // Forgets the real state, after loading another state into the console
+  void clear();
+
+  // Savestate of the real console after the last frame, e.g. for Rewind
+  [[nodiscard]] auto get_state() const -> std::span<const u8>;
+
+private:
+  usize frames;
+
+  std::vector<u8> state;
+  bool is_ahead = false;
+};
+} // namespace nes
@@ -0,0 +1,796 @@
+#include "apu.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <span>
+#include <stdexcept>
+
+#include "cartridge.hpp"
+#include "lib/common.hpp"
+#include "nes/constants.hpp"
+#include "utility/snapshotable.hpp"
+
+namespace nes {
+namespace {
+  constexpr double CPU_CLOCK_RATE = 1'789'773.0; // NTSC
+
+  constexpr auto NO_EVENT = std::numeric_limits<i32>::max();
+
+  constexpr std::array<u8, 32> LENGTH_TABLE = {
+    10, 254, 20, 2,  40, 4,  80, 6,  160, 8,  60, 10, 14, 12, 26, 14,
+    12, 16,  24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30,
+  };
+
+  constexpr std::array<std::array<u8, 8>, 4> DUTY_TABLE = {{
+    {0, 1, 0, 0, 0, 0, 0, 0},
+    {0, 1, 1, 0, 0, 0, 0, 0},
+    {0, 1, 1, 1, 1, 0, 0, 0},
+    {1, 0, 0, 1, 1, 1, 1, 1},
+  }};
+
+  // In CPU cycles
+  constexpr std::array<i32, 16> NOISE_PERIODS = {
+    4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068,
+  };
+
+  constexpr std::array<i32, 16> DMC_PERIODS = {
+    428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54,
+  };
+
+  struct FrameStep {
+    i32 cycle;
+    bool is_half; // Also clocks the length counters and sweeps
+    bool is_irq;
+  };
+
+  // Indexed by the 5-step mode flag
+  constexpr std::array<std::array<FrameStep, 4>, 2> FRAME_STEPS = {{
+    {{{7457, false, false}, {14913, true, false}, {22371, false, false}, {29829, true, true}}},
+    {{{7457, false, false}, {14913, true, false}, {22371, false, false}, {37281, true, false}}},
+  }};
+
+  constexpr std::array<i32, 2> FRAME_PERIODS = {29830, 37282};
+
+  // Nonlinear mixer, see https://www.nesdev.org/wiki/APU_Mixer
+  constexpr auto PULSE_TABLE = [] {
+    std::array<float, 31> table = {};
+
+    for (usize i = 1; i < table.size(); ++i) {
+      table[i] = static_cast<float>(95.52 / ((8128.0 / static_cast<double>(i)) + 100.0));
+    }
+
+    return table;
+  }();
+
+  constexpr auto TND_TABLE = [] {
+    std::array<float, 203> table = {};
+
+    for (usize i = 1; i < table.size(); ++i) {
+      table[i] = static_cast<float>(163.67 / ((24329.0 / static_cast<double>(i)) + 100.0));
+    }
+
+    return table;
+  }();
+
+  // Counts a timer down by `cycles` and returns how many times it expired
+  auto run_timer(i32& timer, const i32 period, const i32 cycles) -> i32 {
+    timer -= cycles;
+
+    if (timer > 0) {
+      return 0;
+    }
+
+    const auto clocks = 1 + (-timer / period);
+    timer += clocks * period;
+
+    return clocks;
+  }
+} // namespace
+
+Apu::Apu(Cartridge& cartridge_ref) :
+  cartridge(&cartridge_ref),
+  blip(CPU_CLOCK_RATE, AUDIO_SAMPLE_RATE) {
+  pulses[0].is_first = true;
+}
+
+void Apu::power_on() {
+  pulses = {};
+  pulses[0].is_first = true;
+  triangle = {};
+  noise = {};
+  dmc = {};
+
+  for (auto& pulse : pulses) {
+    pulse.timer = 2;
+  }
+
+  triangle.timer = 1;
+  noise.timer = NOISE_PERIODS[0];
+  dmc.timer = DMC_PERIODS[0];
+
+  write(0x4017, 0x00);
+
+  blip.clear();
+  audio_cycle = 0;
+  amplitude = 0.0F;
+}
+
+void Apu::reset() {
+  write(0x4015, 0x00);
+
+  // $4017 keeps its value
+  write(0x4017, static_cast<u8>((is_five_step ? 0x80 : 0x00) | (is_irq_inhibited ? 0x40 : 0x00)));
+}
+
+auto Apu::read_status() -> u8 {
+  const auto status = peek_status();
+  frame_irq = false;
+
+  return status;
+}
+
+auto Apu::peek_status() const -> u8 {
+  const auto bit = [](const bool value, const u8 mask) { return value ? mask : u8{0}; };
+
+  return bit(pulses[0].length > 0, 0x01) | bit(pulses[1].length > 0, 0x02) |
+         bit(triangle.length > 0, 0x04) | bit(noise.length > 0, 0x08) |
+         bit(dmc.bytes_remaining > 0, 0x10) | bit(frame_irq, 0x40) | bit(dmc.irq, 0x80);
+}
+
+void Apu::write(const u16 addr, const u8 value) {
+  switch (addr) {
+    case 0x4000:
+    case 0x4001:
+    case 0x4002:
+    case 0x4003: pulses[0].write(addr & 0x03, value); break;
+
+    case 0x4004:
+    case 0x4005:
+    case 0x4006:
+    case 0x4007: pulses[1].write(addr & 0x03, value); break;
+
+    case 0x4008:
+    case 0x4009:
+    case 0x400A:
+    case 0x400B: triangle.write(addr & 0x03, value); break;
+
+    case 0x400C:
+    case 0x400D:
+    case 0x400E:
+    case 0x400F: noise.write(addr & 0x03, value); break;
+
+    case 0x4010:
+      dmc.is_irq_enabled = (value & 0x80) != 0;
+      dmc.is_looping = (value & 0x40) != 0;
+      dmc.rate_index = value & 0x0F;
+
+      if (!dmc.is_irq_enabled) {
+        dmc.irq = false;
+      }
+      break;
+
+    case 0x4011: dmc.level = value & 0x7F; break;
+    case 0x4012: dmc.sample_address = static_cast<u16>(0xC000 + (value * 64)); break;
+    case 0x4013: dmc.sample_length = static_cast<u16>((value * 16) + 1); break;
+
+    case 0x4015:
+      pulses[0].is_enabled = (value & 0x01) != 0;
+      pulses[1].is_enabled = (value & 0x02) != 0;
+      triangle.is_enabled = (value & 0x04) != 0;
+      noise.is_enabled = (value & 0x08) != 0;
+
+      for (auto& pulse : pulses) {
+        pulse.length = pulse.is_enabled ? pulse.length : 0;
+      }
+
+      triangle.length = triangle.is_enabled ? triangle.length : 0;
+      noise.length = noise.is_enabled ? noise.length : 0;
+
+      dmc.irq = false;
+
+      if ((value & 0x10) == 0) {
+        dmc.bytes_remaining = 0;
+      } else if (dmc.bytes_remaining == 0) {
+        restart_dmc();
+        fetch_dmc_sample();
+      }
+      break;
+
+    case 0x4017:
+      // The sequencer restarts right away instead of 3-4 cycles later
+      is_five_step = (value & 0x80) != 0;
+      is_irq_inhibited = (value & 0x40) != 0;
+
+      if (is_irq_inhibited) {
+        frame_irq = false;
+      }
+
+      frame_cycle = 0;
+      frame_step = 0;
+
+      if (is_five_step) {
+        clock_quarter_frame();
+        clock_half_frame();
+      }
+      break;
+
+    default: break;
+  }
+
+  update_output();
+}
+
+void Apu::run(i32 cycles) {
+  while (cycles > 0) {
+    const auto& step = FRAME_STEPS[is_five_step ? 1 : 0][frame_step];
+    const auto until_step = std::min(cycles, step.cycle - frame_cycle);
+
+    run_channels(until_step);
+    frame_cycle += until_step;
+    cycles -= until_step;
+
+    if (frame_cycle == step.cycle) {
+      clock_frame_counter();
+    }
+  }
+}
+
+auto Apu::cycles_until_irq() const -> i32 {
+  auto cycles = NO_EVENT;
+
+  if (!is_five_step && !is_irq_inhibited) {
+    cycles = FRAME_STEPS[0][3].cycle - frame_cycle;
+  }
+
+  // The last byte is fetched when the output unit starts a new cycle
+  if (dmc.is_irq_enabled && !dmc.is_looping && dmc.bytes_remaining > 0) {
+    const auto until_fetch = dmc.timer + ((dmc.bits_remaining - 1) * DMC_PERIODS[dmc.rate_index]);
+    cycles = std::min(cycles, until_fetch);
+  }
+
+  return cycles;
+}
+
+auto Apu::has_irq() const -> bool {
+  return frame_irq || dmc.irq;
+}
+
+void Apu::end_frame() {
+  if (is_output_enabled) {
+    blip.end_frame(audio_cycle);
+  }
+
+  audio_cycle = 0;
+}
+
+void Apu::set_output_enabled(const bool enabled) {
+  is_output_enabled = enabled;
+}
+
+auto Apu::get_output_enabled() const -> bool {
+  return is_output_enabled;
+}
+
+auto Apu::read_samples(const std::span<float> out) -> usize {
+  return blip.read_samples(out);
+}
+
+void Apu::save(utility::SnapshotWriter& out) const {
+  // Field by field, the channels have padding
+  for (const auto& pulse : pulses) {
+    const auto& env = pulse.envelope;
+    dump_snapshot(out, env.volume, env.divider, env.decay);
+    dump_snapshot(out, env.is_constant, env.is_looping, env.is_started);
+    dump_snapshot(out, pulse.timer, pulse.period, pulse.duty, pulse.step, pulse.length);
+    dump_snapshot(out, pulse.sweep_period, pulse.sweep_shift, pulse.sweep_divider);
+    dump_snapshot(out, pulse.is_sweep_enabled, pulse.is_sweep_negated, pulse.is_sweep_reloaded);
+    dump_snapshot(out, pulse.is_enabled);
+  }
+
+  const auto& tri = triangle;
+  dump_snapshot(out, tri.timer, tri.period, tri.step, tri.length);
+  dump_snapshot(out, tri.linear_counter, tri.linear_period);
+  dump_snapshot(out, tri.is_control, tri.is_linear_reloaded, tri.is_enabled);
+
+  const auto& env = noise.envelope;
+  dump_snapshot(out, env.volume, env.divider, env.decay);
+  dump_snapshot(out, env.is_constant, env.is_looping, env.is_started);
+  dump_snapshot(out, noise.timer, noise.shift, noise.period_index, noise.length);
+  dump_snapshot(out, noise.is_short_mode, noise.is_enabled);
+
+  dump_snapshot(out, dmc.timer, dmc.sample_address, dmc.sample_length, dmc.address);
+  dump_snapshot(out, dmc.bytes_remaining, dmc.rate_index, dmc.level, dmc.shift);
+  dump_snapshot(out, dmc.bits_remaining, dmc.buffer, dmc.is_buffer_empty, dmc.is_silent);
+  dump_snapshot(out, dmc.is_looping, dmc.is_irq_enabled, dmc.irq);
+
+  dump_snapshot(out, frame_cycle, frame_step, is_five_step, is_irq_inhibited, frame_irq);
+}
+
+void Apu::load(utility::SnapshotReader& in) {
+  // Read into copies, the APU only changes once everything is known to be valid
+  auto loaded_pulses = pulses;
+  auto loaded_triangle = triangle;
+  auto loaded_noise = noise;
+  auto loaded_dmc = dmc;
+
+  for (auto& pulse : loaded_pulses) {
+    auto& env = pulse.envelope;
+    get_snapshot(in, env.volume, env.divider, env.decay);
+    get_snapshot(in, env.is_constant, env.is_looping, env.is_started);
+    get_snapshot(in, pulse.timer, pulse.period, pulse.duty, pulse.step, pulse.length);
+    get_snapshot(in, pulse.sweep_period, pulse.sweep_shift, pulse.sweep_divider);
+    get_snapshot(in, pulse.is_sweep_enabled, pulse.is_sweep_negated, pulse.is_sweep_reloaded);
+    get_snapshot(in, pulse.is_enabled);
+  }
+
+  auto& tri = loaded_triangle;
+  get_snapshot(in, tri.timer, tri.period, tri.step, tri.length);
+  get_snapshot(in, tri.linear_counter, tri.linear_period);
+  get_snapshot(in, tri.is_control, tri.is_linear_reloaded, tri.is_enabled);
+
+  auto& env = loaded_noise.envelope;
+  get_snapshot(in, env.volume, env.divider, env.decay);
+  get_snapshot(in, env.is_constant, env.is_looping, env.is_started);
+  get_snapshot(in, loaded_noise.timer, loaded_noise.shift, loaded_noise.period_index);
+  get_snapshot(in, loaded_noise.length, loaded_noise.is_short_mode, loaded_noise.is_enabled);
+
+  get_snapshot(in, loaded_dmc.timer, loaded_dmc.sample_address, loaded_dmc.sample_length);
+  get_snapshot(in, loaded_dmc.address, loaded_dmc.bytes_remaining, loaded_dmc.rate_index);
+  get_snapshot(in, loaded_dmc.level, loaded_dmc.shift, loaded_dmc.bits_remaining);
+  get_snapshot(in, loaded_dmc.buffer, loaded_dmc.is_buffer_empty, loaded_dmc.is_silent);
+  get_snapshot(in, loaded_dmc.is_looping, loaded_dmc.is_irq_enabled, loaded_dmc.irq);
+
+  i32 loaded_frame_cycle = 0;
+  u8 loaded_frame_step = 0;
+  bool loaded_five_step = false;
+  bool loaded_irq_inhibited = false;
+  bool loaded_frame_irq = false;
+  get_snapshot(in, loaded_frame_cycle, loaded_frame_step, loaded_five_step);
+  get_snapshot(in, loaded_irq_inhibited, loaded_frame_irq);
+
+  // Table indices, mixer levels (the tables are sized for 4-bit channels and a 7-bit DMC) and
+  // timers, which always stay positive
+  const auto is_valid_envelope = [](const Envelope& envelope) {
+    return envelope.volume <= 15 && envelope.decay <= 15;
+  };
+
+  const auto is_valid_pulse = [&](const Pulse& pulse) {
+    return is_valid_envelope(pulse.envelope) && pulse.timer > 0 &&
+           pulse.duty < DUTY_TABLE.size() && pulse.step < DUTY_TABLE[0].size() &&
+           pulse.sweep_shift <= 7;
+  };
+
+  if (!std::ranges::all_of(loaded_pulses, is_valid_pulse)) {
+    throw std::runtime_error("Invalid snapshot: pulse channel out of range");
+  }
+
+  if (tri.timer <= 0 || tri.step > 31) {
+    throw std::runtime_error("Invalid snapshot: triangle channel out of range");
+  }
+
+  if (!is_valid_envelope(loaded_noise.envelope) || loaded_noise.timer <= 0 ||
+      loaded_noise.period_index >= NOISE_PERIODS.size()) {
+    throw std::runtime_error("Invalid snapshot: noise channel out of range");
+  }
+
+  if (loaded_dmc.timer <= 0 || loaded_dmc.rate_index >= DMC_PERIODS.size() ||
+      loaded_dmc.level > 127 || loaded_dmc.bits_remaining == 0 || loaded_dmc.bits_remaining > 8) {
+    throw std::runtime_error("Invalid snapshot: DMC out of range");
+  }
+
+  // The cycle is -1 right after the sequence wraps around; past the next step, run() would
+  // never reach it
+  if (loaded_frame_step >= FRAME_STEPS[0].size() || loaded_frame_cycle < -1 ||
+      loaded_frame_cycle > FRAME_STEPS[loaded_five_step ? 1 : 0][loaded_frame_step].cycle) {
+    throw std::runtime_error("Invalid snapshot: frame counter out of range");
+  }
+
+  pulses = loaded_pulses;
+  triangle = loaded_triangle;
+  noise = loaded_noise;
+  dmc = loaded_dmc;
+
+  frame_cycle = loaded_frame_cycle;
+  frame_step = loaded_frame_step;
+  is_five_step = loaded_five_step;
+  is_irq_inhibited = loaded_irq_inhibited;
+  frame_irq = loaded_frame_irq;
+
+  // The blip buffer carries on from its current level, the next change steps to the new one
+  update_output();
+}
+
+//
+// Envelope
+//
+
+void Apu::Envelope::clock() {
+  if (is_started) {
+    is_started = false;
+    decay = 15;
+    divider = volume;
+    return;
+  }
+
+  if (divider > 0) {
+    --divider;
+    return;
+  }
+
+  divider = volume;
+
+  if (decay > 0) {
+    --decay;
+  } else if (is_looping) {
+    decay = 15;
+  }
+}
+
+auto Apu::Envelope::output() const -> u8 {
+  return is_constant ? volume : decay;
+}
+
+//
+// Pulse
+//
+
+void Apu::Pulse::write(const u16 reg, const u8 value) {
+  switch (reg) {
+    case 0:
+      duty = value >> 6;
+      envelope.is_looping = (value & 0x20) != 0;
+      envelope.is_constant = (value & 0x10) != 0;
+      envelope.volume = value & 0x0F;
+      break;
+
+    case 1:
+      is_sweep_enabled = (value & 0x80) != 0;
+      sweep_period = (value >> 4) & 0x07;
+      is_sweep_negated = (value & 0x08) != 0;
+      sweep_shift = value & 0x07;
+      is_sweep_reloaded = true;
+      break;
+
+    case 2: period = static_cast<u16>((period & 0x0700) | value); break;
+
+    case 3:
+      period = static_cast<u16>((period & 0x00FF) | ((value & 0x07) << 8));
+      length = is_enabled ? LENGTH_TABLE[value >> 3] : length;
+      step = 0;
+      envelope.is_started = true;
+      break;
+
+    default: unreachable();
+  }
+}
+
+void Apu::Pulse::run(const i32 cycles) {
+  // Clocked every other CPU cycle
+  const auto clocks = run_timer(timer, (period + 1) * 2, cycles);
+  step = static_cast<u8>((step + clocks) & 0x07);
+}
+
+void Apu::Pulse::clock_length() {
+  if (length > 0 && !envelope.is_looping) {
+    --length;
+  }
+}
+
+void Apu::Pulse::clock_sweep() {
+  if (sweep_divider == 0 && is_sweep_enabled && sweep_shift > 0 && !is_muted()) {
+    period = static_cast<u16>(std::max(sweep_target(), 0));
+  }
+
+  if (sweep_divider == 0 || is_sweep_reloaded) {
+    sweep_divider = sweep_period;
+    is_sweep_reloaded = false;
+  } else {
+    --sweep_divider;
+  }
+}
+
+auto Apu::Pulse::sweep_target() const -> i32 {
+  const auto change = period >> sweep_shift;
+
+  if (is_sweep_negated) {
+    return period - change - (is_first ? 1 : 0);
+  }
+
+  return period + change;
+}
+
+auto Apu::Pulse::is_muted() const -> bool {
+  return period < 8 || sweep_target() > 0x07FF;
+}
+
+auto Apu::Pulse::is_audible() const -> bool {
+  return length > 0 && !is_muted() && envelope.output() > 0;
+}
+
+auto Apu::Pulse::output() const -> u8 {
+  if (!is_audible() || DUTY_TABLE[duty][step] == 0) {
+    return 0;
+  }
+
+  return envelope.output();
+}
+
+//
+// Triangle
+//
+
+void Apu::Triangle::write(const u16 reg, const u8 value) {
+  switch (reg) {
+    case 0:
+      is_control = (value & 0x80) != 0;
+      linear_period = value & 0x7F;
+      break;
+
+    case 1: break;
+    case 2: period = static_cast<u16>((period & 0x0700) | value); break;
+
+    case 3:
+      period = static_cast<u16>((period & 0x00FF) | ((value & 0x07) << 8));
+      length = is_enabled ? LENGTH_TABLE[value >> 3] : length;
+      is_linear_reloaded = true;
+      break;
+
+    default: unreachable();
+  }
+}
+
+void Apu::Triangle::run(const i32 cycles) {
+  const auto clocks = run_timer(timer, period + 1, cycles);
+
+  if (is_active()) {
+    step = static_cast<u8>((step + clocks) & 0x1F);
+  }
+}
+
+void Apu::Triangle::clock_length() {
+  if (length > 0 && !is_control) {
+    --length;
+  }
+}
+
+void Apu::Triangle::clock_linear() {
+  if (is_linear_reloaded) {
+    linear_counter = linear_period;
+  } else if (linear_counter > 0) {
+    --linear_counter;
+  }
+
+  if (!is_control) {
+    is_linear_reloaded = false;
+  }
+}
+
+auto Apu::Triangle::is_active() const -> bool {
+  return length > 0 && linear_counter > 0 && period >= 2;
+}
+
+auto Apu::Triangle::output() const -> u8 {
+  // 15 down to 0, then 0 up to 15
+  return step < 16 ? static_cast<u8>(15 - step) : static_cast<u8>(step - 16);
+}
+
+//
+// Noise
+//
+
+void Apu::Noise::write(const u16 reg, const u8 value) {
+  switch (reg) {
+    case 0:
+      envelope.is_looping = (value & 0x20) != 0;
+      envelope.is_constant = (value & 0x10) != 0;
+      envelope.volume = value & 0x0F;
+      break;
+
+    case 1: break;
+
+    case 2:
+      is_short_mode = (value & 0x80) != 0;
+      period_index = value & 0x0F;
+      break;
+
+    case 3:
+      length = is_enabled ? LENGTH_TABLE[value >> 3] : length;
+      envelope.is_started = true;
+      break;
+
+    default: unreachable();
+  }
+}
+
+void Apu::Noise::run(const i32 cycles) {
+  const auto clocks = run_timer(timer, NOISE_PERIODS[period_index], cycles);
+  const auto tap = is_short_mode ? 6 : 1;
+
+  for (i32 i = 0; i < clocks; ++i) {
+    const auto feedback = (shift ^ (shift >> tap)) & 0x01;
+    shift = static_cast<u16>((shift >> 1) | (feedback << 14));
+  }
+}
+
+void Apu::Noise::clock_length() {
+  if (length > 0 && !envelope.is_looping) {
+    --length;
+  }
+}
+
+auto Apu::Noise::is_audible() const -> bool {
+  return length > 0 && envelope.output() > 0;
+}
+
+auto Apu::Noise::output() const -> u8 {
+  return is_audible() && (shift & 0x01) == 0 ? envelope.output() : 0;
+}
+
+//
+// DMC
+//
+
+void Apu::run_dmc(const i32 cycles) {
+  const auto clocks = run_timer(dmc.timer, DMC_PERIODS[dmc.rate_index], cycles);
+
+  for (i32 i = 0; i < clocks; ++i) {
+    clock_dmc();
+  }
+}
+
+void Apu::clock_dmc() {
+  if (!dmc.is_silent) {
+    if ((dmc.shift & 0x01) != 0) {
+      dmc.level = dmc.level <= 125 ? static_cast<u8>(dmc.level + 2) : dmc.level;
+    } else {
+      dmc.level = dmc.level >= 2 ? static_cast<u8>(dmc.level - 2) : dmc.level;
+    }
+  }
+
+  dmc.shift >>= 1;
+
+  if (--dmc.bits_remaining > 0) {
+    return;
+  }
+
+  // New output cycle
+  dmc.bits_remaining = 8;
+  dmc.is_silent = dmc.is_buffer_empty;
+
+  if (!dmc.is_buffer_empty) {
+    dmc.shift = dmc.buffer;
+    dmc.is_buffer_empty = true;
+    fetch_dmc_sample();
+  }
+}
+
+void Apu::fetch_dmc_sample() {
+  if (!dmc.is_buffer_empty || dmc.bytes_remaining == 0) {
+    return;
+  }
+
+  dmc.buffer = cartridge->prg_read(dmc.address);
+  dmc.is_buffer_empty = false;
+  dmc.address = dmc.address == 0xFFFF ? 0x8000 : static_cast<u16>(dmc.address + 1);
+
+  if (--dmc.bytes_remaining > 0) {
+    return;
+  }
+
+  if (dmc.is_looping) {
+    restart_dmc();
+  } else if (dmc.is_irq_enabled) {
+    dmc.irq = true;
+  }
+}
+
+void Apu::restart_dmc() {
+  dmc.address = dmc.sample_address;
+  dmc.bytes_remaining = dmc.sample_length;
+}
+
+//
+// Frame counter
+//
+
+void Apu::clock_frame_counter() {
+  const auto& step = FRAME_STEPS[is_five_step ? 1 : 0][frame_step];
+
+  clock_quarter_frame();
+
+  if (step.is_half) {
+    clock_half_frame();
+  }
+
+  if (step.is_irq && !is_irq_inhibited) {
+    frame_irq = true;
+  }
+
+  if (++frame_step == FRAME_STEPS[0].size()) {
+    frame_step = 0;
+    frame_cycle -= FRAME_PERIODS[is_five_step ? 1 : 0];
+  }
+
+  update_output();
+}
+
+void Apu::clock_quarter_frame() {
+  pulses[0].envelope.clock();
+  pulses[1].envelope.clock();
+  noise.envelope.clock();
+  triangle.clock_linear();
+}
+
+void Apu::clock_half_frame() {
+  for (auto& pulse : pulses) {
+    pulse.clock_length();
+    pulse.clock_sweep();
+  }
+
+  triangle.clock_length();
+  noise.clock_length();
+}
+
+//
+// Output
+//
+
+// Runs the channels from one output change to the next. Timers of silent channels are
+// advanced in bulk; without output nothing needs to be split.
+void Apu::run_channels(i32 cycles) {
+  while (cycles > 0) {
+    const auto step = is_output_enabled ? std::min(cycles, cycles_until_output_change()) : cycles;
+
+    pulses[0].run(step);
+    pulses[1].run(step);
+    triangle.run(step);
+    noise.run(step);
+    run_dmc(step);
+
+    cycles -= step;
+    audio_cycle += static_cast<u32>(step);
+
+    update_output();
+  }
+}
+
+auto Apu::cycles_until_output_change() const -> i32 {
+  auto cycles = NO_EVENT;
+
+  for (const auto& pulse : pulses) {
+    if (pulse.is_audible()) {
+      cycles = std::min(cycles, pulse.timer);
+    }
+  }
+
+  if (triangle.is_active()) {
+    cycles = std::min(cycles, triangle.timer);
+  }
+
+  if (noise.is_audible()) {
+    cycles = std::min(cycles, noise.timer);
+  }
+
+  if (!dmc.is_silent) {
+    cycles = std::min(cycles, dmc.timer);
+  }
+
+  return cycles;
+}
+
+void Apu::update_output() {
+  if (!is_output_enabled) {
+    return;
+  }
+
+  const auto pulse = static_cast<usize>(pulses[0].output() + pulses[1].output());
+  const auto tnd = static_cast<usize>((3 * triangle.output()) + (2 * noise.output()) + dmc.level);
+  const auto value = PULSE_TABLE[pulse] + TND_TABLE[tnd];
+
+  if (value != amplitude) {
+    blip.add_delta(audio_cycle, value - amplitude);
+    amplitude = value;
+  }
+}
+} // namespace nes
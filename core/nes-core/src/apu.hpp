@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <span>
+
+#include "lib/common.hpp"
+#include "utility/blip_buffer.hpp"
+#include "utility/snapshotable.hpp"
+
+namespace nes {
+class Cartridge;
+
+// 2A03 audio: two pulse channels, triangle, noise, DMC and the frame counter.
+// The APU is event driven, it runs from one change of its output to the next and the mixer
+// output is synthesized with band-limited steps, so the cost follows the number of changes.
+class Apu final: public utility::Snapshotable {
+public:
+  explicit Apu(Cartridge& cartridge_ref);
+
+  void power_on();
+  void reset();
+
+  [[nodiscard]] auto read_status() -> u8; // $4015, clears the frame IRQ
+  void write(u16 addr, u8 value);
+
+  void run(i32 cycles); // Catch-up: runs several CPU cycles at once
+
+  // Number of CPU cycles that can run before the APU may raise an IRQ
+  [[nodiscard]] auto cycles_until_irq() const -> i32;
+  [[nodiscard]] auto has_irq() const -> bool;
+
+  // Ends the audio frame, its samples can be read afterwards
+  void end_frame();
+
+  // Without output the channels still run but nothing is synthesized. Off by default.
+  void set_output_enabled(bool enabled);
+  [[nodiscard]] auto get_output_enabled() const -> bool;
+
+  // Mono samples at AUDIO_SAMPLE_RATE, returns the number written to `out`
+  auto read_samples(std::span<float> out) -> usize;
+
+  // Registers, channels and frame counter. Samples not read yet aren't part of the state.
+  void save(utility::SnapshotWriter& out) const override;
+  void load(utility::SnapshotReader& in) override;
+
+  //
+  // Read without side effects
+  //
+
+  [[nodiscard]] auto peek_status() const -> u8;
+
+private:
+  Cartridge* cartridge;
+
+  //
+  // Channel units
+  //
+
+  struct Envelope {
+    u8 volume = 0; // Constant volume or decay period
+    u8 divider = 0;
+    u8 decay = 0;
+    bool is_constant = false;
+    bool is_looping = false; // Also halts the length counter
+    bool is_started = false;
+
+    void clock();
+    [[nodiscard]] auto output() const -> u8;
+  };
+
+  struct Pulse {
+    Envelope envelope;
+    i32 timer = 0;   // CPU cycles until the next sequencer step
+    u16 period = 0;  // 11-bit timer period
+    u8 duty = 0;
+    u8 step = 0;     // Sequencer position
+    u8 length = 0;   // Length counter
+    u8 sweep_period = 0;
+    u8 sweep_shift = 0;
+    u8 sweep_divider = 0;
+    bool is_sweep_enabled = false;
+    bool is_sweep_negated = false;
+    bool is_sweep_reloaded = false;
+    bool is_enabled = false;
+    bool is_first = false; // Pulse 1 negates with ones' complement
+
+    void write(u16 reg, u8 value);
+    void run(i32 cycles);
+    void clock_length();
+    void clock_sweep();
+
+    [[nodiscard]] auto sweep_target() const -> i32;
+    [[nodiscard]] auto is_muted() const -> bool;
+    [[nodiscard]] auto is_audible() const -> bool; // The output may change at the next step
+    [[nodiscard]] auto output() const -> u8;
+  };
+
+  struct Triangle {
+    i32 timer = 0;
+    u16 period = 0;
+    u8 step = 0;
+    u8 length = 0;
+    u8 linear_counter = 0;
+    u8 linear_period = 0;
+    bool is_control = false; // Halts the length counter
+    bool is_linear_reloaded = false;
+    bool is_enabled = false;
+
+    void write(u16 reg, u8 value);
+    void run(i32 cycles);
+    void clock_length();
+    void clock_linear();
+
+    // Ultrasonic periods are frozen instead of stepped, like most emulators, avoiding pops
+    [[nodiscard]] auto is_active() const -> bool;
+    [[nodiscard]] auto output() const -> u8;
+  };
+
+  struct Noise {
+    Envelope envelope;
+    i32 timer = 0;
+    u16 shift = 1; // Linear feedback shift register
+    u8 period_index = 0;
+    u8 length = 0;
+    bool is_short_mode = false;
+    bool is_enabled = false;
+
+    void write(u16 reg, u8 value);
+    void run(i32 cycles);
+    void clock_length();
+
+    [[nodiscard]] auto is_audible() const -> bool;
+    [[nodiscard]] auto output() const -> u8;
+  };
+
+  struct Dmc {
+    i32 timer = 0;
+    u16 sample_address = 0xC000;
+    u16 sample_length = 1;
+    u16 address = 0xC000;  // Memory reader
+    u16 bytes_remaining = 0;
+    u8 rate_index = 0;
+    u8 level = 0;          // Output level (7 bits)
+    u8 shift = 0;          // Output unit
+    u8 bits_remaining = 8;
+    u8 buffer = 0;         // Sample buffer
+    bool is_buffer_empty = true;
+    bool is_silent = true;
+    bool is_looping = false;
+    bool is_irq_enabled = false;
+    bool irq = false;
+  };
+
+  std::array<Pulse, 2> pulses = {};
+  Triangle triangle;
+  Noise noise;
+  Dmc dmc;
+
+  // The DMC reads its samples from the cartridge, the CPU stall cycles aren't emulated
+  void run_dmc(i32 cycles);
+  void clock_dmc();
+  void fetch_dmc_sample();
+  void restart_dmc();
+
+  //
+  // Frame counter
+  //
+
+  i32 frame_cycle = 0; // CPU cycles since the start of the sequence
+  u8 frame_step = 0;   // Next step of the sequence
+  bool is_five_step = false;
+  bool is_irq_inhibited = false;
+  bool frame_irq = false;
+
+  void clock_frame_counter();
+  void clock_quarter_frame(); // Envelopes and linear counter
+  void clock_half_frame();    // Length counters and sweeps
+
+  //
+  // Output
+  //
+
+  void run_channels(i32 cycles);
+  [[nodiscard]] auto cycles_until_output_change() const -> i32;
+  void update_output();
+
+  utility::BlipBuffer blip;
+  bool is_output_enabled = false;
+  u32 audio_cycle = 0;    // CPU cycles since the start of the audio frame
+  float amplitude = 0.0F; // Mixer output last added to the blip buffer
+};
+} // namespace nes
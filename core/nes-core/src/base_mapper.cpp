@@ -1,6 +1,12 @@
 #include "base_mapper.hpp"
 
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
 #include "lib/common.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
 auto BaseMapper::get_mirroring() const -> MirroringType {
@@ -8,25 +14,33 @@ auto BaseMapper::get_mirroring() const -> MirroringType {
 }
 
 void BaseMapper::set_mirroring(const MirroringType value) {
-  mirroring = value;
+  if (mirroring != value) {
+    mirroring = value;
+    mirroring_changed = true;
+  }
 }
 
-void BaseMapper::set_irq(const bool value) const {
-  *irq = value;
+auto BaseMapper::take_mirroring_changed() -> bool {
+  return std::exchange(mirroring_changed, false);
 }
 
-auto BaseMapper::get_prg_addr(const u16 addr) const -> usize {
-  const usize slot = (addr - 0x8000u) / 0x2000u;
-  const usize prg_addr = (addr - 0x8000u) % 0x2000u;
-
-  return prg_map[slot] + prg_addr;
+void BaseMapper::set_memory(
+  const std::span<const u8> prg_memory,
+  const std::span<const u8> chr_memory
+) {
+  prg = prg_memory;
+  chr = chr_memory;
+  update_banks();
 }
 
-auto BaseMapper::get_chr_addr(const u16 addr) const -> usize {
-  const usize slot = addr / 0x400;
-  const usize chr_addr = addr % 0x400;
+void BaseMapper::update_banks() {
+  for (usize slot = 0; slot < prg_map.size(); ++slot) {
+    prg_banks[slot] = prg.data() + prg_map[slot];
+  }
 
-  return chr_map[slot] + chr_addr;
+  for (usize slot = 0; slot < chr_map.size(); ++slot) {
+    chr_banks[slot] = chr.data() + chr_map[slot];
+  }
 }
 
 void BaseMapper::write(const u16 addr, const u8 value) {
@@ -41,13 +55,20 @@ void BaseMapper::set_prg_map(const usize slot, i32 page) {
   constexpr usize pages_b = Size * 0x400; // In bytes
 
   if (page < 0) {
-    page += static_cast<i32>(prg_size) / static_cast<i32>(pages_b);
+    page += static_cast<i32>(prg.size()) / static_cast<i32>(pages_b);
   }
 
   const auto resolved_page = static_cast<usize>(page);
 
   for (usize i = 0; i < pages; ++i) {
-    prg_map[(pages * slot) + i] = ((pages_b * resolved_page) + 0x2000u * i) % prg_size;
+    const auto offset = ((pages_b * resolved_page) + 0x2000u * i) % prg.size();
+    const auto index = (pages * slot) + i;
+
+    if (prg_map[index] != offset) {
+      prg_map[index] = offset;
+      prg_banks[index] = prg.data() + offset;
+      prg_map_changed = true;
+    }
   }
 }
 
@@ -58,11 +79,44 @@ void BaseMapper::set_chr_map(const usize slot, const usize page) {
   constexpr usize pages_b = Size * 0x400; // In bytes
 
   for (usize i = 0; i < Size; ++i) {
-    chr_map[(pages * slot) + i] = ((pages_b * page) + 0x400u * i) % chr_size;
+    const auto offset = ((pages_b * page) + 0x400u * i) % chr.size();
+    const auto index = (pages * slot) + i;
+
+    chr_map[index] = offset;
+    chr_banks[index] = chr.data() + offset;
   }
 }
 
-void BaseMapper::increment_scanline_counter() {}
+void BaseMapper::save(utility::SnapshotWriter& out) const {
+  dump_snapshot(out, mirroring, prg_map, chr_map);
+}
+
+void BaseMapper::load(utility::SnapshotReader& in) {
+  get_snapshot(in, mirroring, prg_map, chr_map);
+
+  const auto is_in_range = [](const auto& map, const usize bank_size, const usize memory_size) {
+    return std::ranges::all_of(map, [&](const usize offset) {
+      return offset + bank_size <= memory_size;
+    });
+  };
+
+  if (!is_in_range(prg_map, 0x2000, prg.size()) || !is_in_range(chr_map, 0x400, chr.size())) {
+    throw std::runtime_error("Invalid snapshot: bank out of range");
+  }
+
+  // Whether four-screen is valid depends on the board, the cartridge checks it
+  if (mirroring == MirroringType::Unknown || mirroring > MirroringType::FourScreen) {
+    throw std::runtime_error("Invalid snapshot: mirroring out of range");
+  }
+
+  update_banks();
+  prg_map_changed = true;
+  mirroring_changed = true;
+}
+
+auto BaseMapper::take_prg_map_changed() -> bool {
+  return std::exchange(prg_map_changed, false);
+}
 
 // Explicit instantiation
 template void BaseMapper::set_prg_map<32>(usize, i32);
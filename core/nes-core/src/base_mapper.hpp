@@ -2,33 +2,78 @@
 
 #include <array>
 #include <memory>
+#include <span>
 
 #include "lib/common.hpp"
 #include "types/ppu_types.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
-class BaseMapper {
+// State and banking shared by the mappers. Cartridge holds the concrete mapper in a
+// std::variant (see mappers/mappers.hpp) and calls it without virtual dispatch: a mapper
+// defines reset() and hides write(), increment_scanline_counter() and has_scanline_irq() to
+// change what they do.
+class BaseMapper: public utility::Snapshotable {
 public:
   using MirroringType = types::ppu::MirroringType;
 
   BaseMapper() = default;
-  virtual ~BaseMapper() = default;
+  ~BaseMapper() override = default;
 
   BaseMapper(const BaseMapper&) = delete;
   auto operator=(const BaseMapper&) -> BaseMapper& = delete;
   BaseMapper(const BaseMapper&&) = delete;
   auto operator=(BaseMapper&&) -> BaseMapper& = delete;
 
-  virtual void reset() = 0;
+  // Mappers with registers of their own extend these
+  void save(utility::SnapshotWriter& out) const override;
+  void load(utility::SnapshotReader& in) override;
 
   [[nodiscard]] auto get_mirroring() const -> MirroringType;
   void set_mirroring(MirroringType value);
-  void set_irq(bool value) const;
 
-  [[nodiscard]] auto get_prg_addr(u16 addr) const -> usize;
-  [[nodiscard]] auto get_chr_addr(u16 addr) const -> usize;
+  // Returns whether the mirroring was changed since the last call
+  [[nodiscard]] auto take_mirroring_changed() -> bool;
 
-  virtual void write(u16 addr, u8 value);
+  void set_irq(const bool value) const {
+    *irq = value;
+  }
+
+  // Host memory of PRG-ROM and CHR, set by the cartridge before reset()
+  void set_memory(std::span<const u8> prg_memory, std::span<const u8> chr_memory);
+
+  // Host pointers to the mapped banks, kept up to date on every bank switch: 8KB PRG-ROM slots
+  // from $8000 and 1KB CHR slots from $0000. The CPU page table and the PPU read through them.
+  using PrgBanks = std::array<const u8*, 4>;
+  using ChrBanks = std::array<const u8*, 8>;
+
+  [[nodiscard]] auto get_prg_banks() const -> const PrgBanks& {
+    return prg_banks;
+  }
+
+  [[nodiscard]] auto get_chr_banks() const -> const ChrBanks& {
+    return chr_banks;
+  }
+
+  [[nodiscard]] auto read_prg(const u16 addr) const -> u8 {
+    return prg_banks[(addr >> 13) & 0b11][addr & 0x1FFF];
+  }
+
+  [[nodiscard]] auto read_chr(const u16 addr) const -> u8 {
+    return chr_banks[(addr >> 10) & 0b111][addr & 0x3FF];
+  }
+
+  // Offsets in PRG-ROM and CHR of the mapped byte, for what is indexed by offset rather than
+  // by address (the decoded CHR, the CPU block cache)
+  [[nodiscard]] auto get_prg_addr(const u16 addr) const -> usize {
+    return prg_map[(addr >> 13) & 0b11] + (addr & 0x1FFF);
+  }
+
+  [[nodiscard]] auto get_chr_addr(const u16 addr) const -> usize {
+    return chr_map[(addr >> 10) & 0b111] + (addr & 0x3FF);
+  }
+
+  void write(u16 addr, u8 value);
 
   template <std::size_t Size>
   void set_prg_map(usize slot, i32 page);
@@ -36,18 +81,34 @@ public:
   template <std::size_t Size>
   void set_chr_map(usize slot, usize page);
 
-  virtual void increment_scanline_counter();
+  // Returns whether the PRG banks were switched since the last call
+  [[nodiscard]] auto take_prg_map_changed() -> bool;
+
+  void increment_scanline_counter() {}
+
+  // Whether increment_scanline_counter() may raise an IRQ
+  [[nodiscard]] auto has_scanline_irq() const -> bool {
+    return false;
+  }
 
   // TODO: fix this
   std::shared_ptr<bool> irq;
 
-  usize prg_size = 0;
-  usize chr_size = 0;
-
 private:
   MirroringType mirroring = MirroringType::Unknown;
+  bool mirroring_changed = true;
 
+  std::span<const u8> prg;
+  std::span<const u8> chr;
+
+  // Offsets of the banks (saved in snapshots) and the pointers derived from them
   std::array<usize, 4> prg_map = {};
+  bool prg_map_changed = true;
   std::array<usize, 8> chr_map = {};
+
+  PrgBanks prg_banks = {};
+  ChrBanks chr_banks = {};
+
+  void update_banks();
 };
 } // namespace nes
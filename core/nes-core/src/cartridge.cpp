@@ -2,72 +2,124 @@
 
 #include <algorithm>
 #include <format>
-#include <iterator>
 #include <memory>
-#include <ranges>
 #include <span>
 #include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 
 #include "base_mapper.hpp"
 #include "lib/common.hpp"
-#include "mappers/mapper_0.hpp"
-#include "mappers/mapper_1.hpp"
-#include "mappers/mapper_2.hpp"
-#include "mappers/mapper_4.hpp"
-#include "mappers/mapper_7.hpp"
+#include "mappers/mappers.hpp"
 #include "types/ppu_types.hpp"
+#include "utility/rom_image.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
-auto Cartridge::get() -> Cartridge& {
-  static Cartridge instance;
-  return instance;
-}
+namespace {
+  constexpr usize chr_bank_size = 0x400;
+
+  // Spreads the bits of a bitplane so that each one is followed by a zero bit
+  constexpr auto spread_bits(const u8 value) -> u16 {
+    auto bits = static_cast<u16>(value);
+    bits = (bits | static_cast<u16>(bits << 4)) & 0x0F0F;
+    bits = (bits | static_cast<u16>(bits << 2)) & 0x3333;
+    bits = (bits | static_cast<u16>(bits << 1)) & 0x5555;
+    return bits;
+  }
+
+  constexpr auto reverse_bits(const u8 value) -> u8 {
+    u8 reversed = 0;
+
+    for (usize i = 0; i < 8; ++i) {
+      reversed |= static_cast<u8>(((value >> i) & 1) << (7 - i));
+    }
+
+    return reversed;
+  }
+
+  constexpr auto decode_row(const u8 low, const u8 high) -> u16 {
+    return spread_bits(low) | static_cast<u16>(spread_bits(high) << 1);
+  }
+
+  static_assert(decode_row(0b1000'0001, 0b1100'0000) == 0b11'10'00'00'00'00'00'01);
+
+  // The CPU pages, the CHR banks and the PPU nametables point into these: the contents are
+  // checked first and copied in place, never reallocated
+  void load_memory(
+    utility::SnapshotReader& in,
+    std::vector<u8>& memory,
+    const std::string_view name
+  ) {
+    auto loaded = std::vector<u8>();
+    in.read(loaded);
+
+    if (loaded.size() != memory.size()) {
+      throw std::runtime_error(std::format("Invalid snapshot: {} size mismatch", name));
+    }
+
+    std::ranges::copy(loaded, memory.begin());
+  }
+} // namespace
 
 auto Cartridge::get_mapper() const -> BaseMapper* {
-  return mapper.get();
+  return base_mapper;
 }
 
 auto Cartridge::get_mirroring() const -> MirroringType {
-  return mapper->get_mirroring();
+  return base_mapper->get_mirroring();
 }
 
 void Cartridge::load(
-  const std::vector<u8>& rom,
+  utility::RomImage rom_image,
   const std::optional<std::vector<u8>>& prg_ram_file,
   std::shared_ptr<bool> irq
 ) {
-  const std::span header(rom.begin(), rom.begin() + 16);
+  constexpr usize header_size = 16;
+
+  rom = std::move(rom_image);
+  const auto data = rom.get_data();
+
+  if (data.size() < header_size) {
+    throw std::runtime_error("Invalid ROM: missing header");
+  }
+
+  const auto header = data.first(header_size);
 
   const usize mapper_num = (header[7] & 0xF0) | (header[6] >> 4);
   const usize prg_size = static_cast<usize>(header[4]) * 0x4000;
   const usize chr_size = static_cast<usize>(header[5]) * 0x2000;
-  const bool has_chr_ram = chr_size == 0;
+  has_chr_ram = chr_size == 0;
   const usize prg_ram_size = header[8] != 0 ? header[8] * 0x2000 : 0x2000;
-  const auto mirroring =
-    (header[6] & 0b1) != 0 ? MirroringType::Vertical : MirroringType::Horizontal;
+  const auto is_four_screen = (header[6] & 0b1000) != 0;
+  const auto mirroring = is_four_screen           ? MirroringType::FourScreen
+                         : (header[6] & 0b1) != 0 ? MirroringType::Vertical
+                                                  : MirroringType::Horizontal;
 
-  // PRG
-  constexpr usize prg_start = 16;
+  if (const auto rom_size = header_size + prg_size + chr_size; data.size() < rom_size) {
+    throw std::runtime_error(
+      std::format("Invalid ROM: {} bytes, expected {}", data.size(), rom_size)
+    );
+  }
 
-  prg = rom
-    | std::ranges::views::drop(prg_start)
-    | std::ranges::views::take(prg_size)
-    | std::ranges::to<std::vector>();
+  // PRG
+  prg = data.subspan(header_size, prg_size);
 
   // CHR
   if (!has_chr_ram) {
-    const usize chr_start = prg_start + prg_size;
-
-    chr = rom
-      | std::ranges::views::drop(chr_start)
-      | std::ranges::views::take(chr_size)
-      | std::ranges::to<std::vector>();
+    chr = data.subspan(header_size + prg_size, chr_size);
+    chr_ram.clear();
   } else {
-    chr.resize(0x2000);
+    chr_ram.assign(0x2000, 0);
+    chr = chr_ram;
   }
 
+  // Four-screen VRAM
+  vram.assign(is_four_screen ? 0x1000 : 0, 0);
+
   // PRG-RAM
   if (prg_ram_file) {
     prg_ram = *prg_ram_file;
@@ -76,19 +128,24 @@ void Cartridge::load(
   }
 
   switch (mapper_num) {
-    case 0: mapper = std::make_unique<Mapper0>(); break;
-    case 1: mapper = std::make_unique<Mapper1>(); break;
-    case 2: mapper = std::make_unique<Mapper2>(); break;
-    case 4: mapper = std::make_unique<Mapper4>(); break;
-    case 7: mapper = std::make_unique<Mapper7>(); break;
+    case 0: mapper.emplace<Mapper0>(); break;
+    case 1: mapper.emplace<Mapper1>(); break;
+    case 2: mapper.emplace<Mapper2>(); break;
+    case 4: mapper.emplace<Mapper4>(); break;
+    case 7: mapper.emplace<Mapper7>(); break;
     default: throw std::runtime_error(std::format("Mapper #{} not implemented", mapper_num));
   }
 
-  mapper->prg_size = prg.size();
-  mapper->chr_size = chr.size();
-  mapper->irq = std::move(irq);
-  mapper->set_mirroring(mirroring);
-  mapper->reset();
+  base_mapper = std::visit([](auto& concrete) -> BaseMapper* { return &concrete; }, mapper);
+
+  chr_rows.assign(chr.size() / 2, 0);
+  chr_rows_flipped.assign(chr.size() / 2, 0);
+  chr_bank_dirty.assign(chr.size() / chr_bank_size, true);
+
+  base_mapper->set_memory(prg, chr);
+  base_mapper->irq = std::move(irq);
+  base_mapper->set_mirroring(mirroring);
+  std::visit([](auto& concrete) { concrete.reset(); }, mapper);
 
   spdlog::info("PRG-ROM size (16KB banks): {}", prg_size);
   spdlog::info("CHR-ROM size (8KB banks): {}", chr_size);
@@ -102,8 +159,7 @@ auto Cartridge::prg_read(const u16 addr) const -> u8 {
     return prg_ram[addr - 0x6000];
   }
 
-  const usize mapped_addr = mapper->get_prg_addr(addr);
-  return prg[mapped_addr];
+  return base_mapper->read_prg(addr);
 }
 
 void Cartridge::prg_write(const u16 addr, const u8 value) {
@@ -112,23 +168,157 @@ void Cartridge::prg_write(const u16 addr, const u8 value) {
     return;
   }
 
-  mapper->write(addr, value);
+  std::visit([addr, value](auto& concrete) { concrete.write(addr, value); }, mapper);
 }
 
 auto Cartridge::chr_read(const u16 addr) const -> u8 {
-  const usize mapped_addr = mapper->get_chr_addr(addr);
-  return chr[mapped_addr];
+  return base_mapper->read_chr(addr);
+}
+
+auto Cartridge::get_rom() const -> std::span<const u8> {
+  return rom.get_data();
 }
 
 void Cartridge::chr_write(const u16 addr, const u8 value) {
+  // CHR-ROM is the mapped image itself
+  if (!has_chr_ram) {
+    return;
+  }
+
   chr[addr] = value;
+  chr_bank_dirty[addr / chr_bank_size] = true;
+}
+
+auto Cartridge::get_chr_row(const u16 addr) -> u16 {
+  return chr_rows[get_chr_row_index(addr)];
+}
+
+auto Cartridge::get_chr_row_flipped(const u16 addr) -> u16 {
+  return chr_rows_flipped[get_chr_row_index(addr)];
+}
+
+auto Cartridge::get_chr_row_index(const u16 addr) -> usize {
+  const usize mapped_addr = base_mapper->get_chr_addr(addr);
+  const usize bank = mapped_addr / chr_bank_size;
+
+  if (chr_bank_dirty[bank]) {
+    decode_chr_bank(bank);
+  }
+
+  // 16 bytes (two bitplanes) per tile in CHR, 8 rows per tile once decoded
+  return ((mapped_addr & ~usize{0x0F}) >> 1) | (mapped_addr & 0x07);
+}
+
+void Cartridge::decode_chr_bank(const usize bank) {
+  for (auto tile = bank * chr_bank_size; tile < (bank + 1) * chr_bank_size; tile += 16) {
+    for (usize row = 0; row < 8; ++row) {
+      const auto low = chr[tile + row];
+      const auto high = chr[tile + row + 8];
+      const auto index = (tile >> 1) | row;
+
+      chr_rows[index] = decode_row(low, high);
+      chr_rows_flipped[index] = decode_row(reverse_bits(low), reverse_bits(high));
+    }
+  }
+
+  chr_bank_dirty[bank] = false;
+}
+
+auto Cartridge::get_prg_read_page(const u16 addr) const -> const u8* {
+  if (addr < 0x6000) {
+    return nullptr;
+  }
+
+  if (addr < 0x8000) {
+    const usize offset = addr - 0x6000u;
+    return offset + 0x100 <= prg_ram.size() ? &prg_ram[offset] : nullptr;
+  }
+
+  return base_mapper->get_prg_banks()[(addr >> 13) & 0b11] + (addr & 0x1FFF);
+}
+
+auto Cartridge::get_prg_write_page(const u16 addr) -> u8* {
+  if (addr < 0x6000 || addr >= 0x8000) {
+    return nullptr; // Writes to PRG-ROM are handled by the mapper
+  }
+
+  const usize offset = addr - 0x6000u;
+  return offset + 0x100 <= prg_ram.size() ? &prg_ram[offset] : nullptr;
 }
 
-void Cartridge::scanline_counter() const {
-  mapper->increment_scanline_counter();
+auto Cartridge::take_prg_map_changed() -> bool {
+  return base_mapper->take_prg_map_changed();
+}
+
+auto Cartridge::get_nametable_pages(const std::span<u8, 0x800> ci_ram) -> NametablePages {
+  using enum MirroringType;
+
+  // Four-screen boards ignore the mirroring the mapper selects
+  if (!vram.empty()) {
+    return {&vram[0x000], &vram[0x400], &vram[0x800], &vram[0xC00]};
+  }
+
+  auto* const low = &ci_ram[0x000];
+  auto* const high = &ci_ram[0x400];
+
+  switch (base_mapper->get_mirroring()) {
+    case Vertical: return {low, high, low, high};
+    case Horizontal: return {low, low, high, high};
+    case OneScreenLow: return {low, low, low, low};
+    case OneScreenHigh: return {high, high, high, high};
+    case FourScreen: throw std::runtime_error("Four-screen mirroring without cartridge VRAM");
+    case Unknown: throw std::runtime_error("Invalid mirroring type");
+
+    default: unreachable();
+  }
+}
+
+auto Cartridge::take_mirroring_changed() -> bool {
+  return base_mapper->take_mirroring_changed();
+}
+
+auto Cartridge::get_prg_offset(const u16 addr) const -> usize {
+  return base_mapper->get_prg_addr(addr);
+}
+
+auto Cartridge::get_prg_size() const -> usize {
+  return prg.size();
 }
 
 auto Cartridge::get_prg_ram() const -> std::vector<u8> {
   return prg_ram;
 }
+
+void Cartridge::save(utility::SnapshotWriter& out) const {
+  dump_snapshot(out, prg_ram);
+
+  if (has_chr_ram) {
+    dump_snapshot(out, chr_ram);
+  }
+
+  if (!vram.empty()) {
+    dump_snapshot(out, vram);
+  }
+
+  std::visit([&out](const auto& concrete) { concrete.save(out); }, mapper);
+}
+
+void Cartridge::load(utility::SnapshotReader& in) {
+  load_memory(in, prg_ram, "PRG-RAM");
+
+  if (has_chr_ram) {
+    load_memory(in, chr_ram, "CHR-RAM");
+    chr_bank_dirty.assign(chr_bank_dirty.size(), true);
+  }
+
+  if (!vram.empty()) {
+    load_memory(in, vram, "VRAM");
+  }
+
+  std::visit([&in](auto& concrete) { concrete.load(in); }, mapper);
+
+  if (vram.empty() && get_mirroring() == MirroringType::FourScreen) {
+    throw std::runtime_error("Invalid snapshot: four-screen mirroring without VRAM");
+  }
+}
 } // namespace nes
@@ -1,47 +1,101 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <optional>
 #include <span>
+#include <variant>
 #include <vector>
 
 #include "base_mapper.hpp"
 #include "lib/common.hpp"
+#include "mappers/mappers.hpp"
+#include "utility/rom_image.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
-class Cartridge final {
+class Cartridge final: public utility::Snapshotable {
 public:
   using MirroringType = BaseMapper::MirroringType;
 
-  static auto get() -> Cartridge&;
-
   [[nodiscard]] auto get_mapper() const -> BaseMapper*;
   [[nodiscard]] auto get_mirroring() const -> MirroringType;
 
+  // PRG-ROM and CHR-ROM are used in place, the cartridge keeps the image
   void load(
-    const std::vector<u8>& rom,
+    utility::RomImage rom_image,
     const std::optional<std::vector<u8>>& prg_ram_file,
     std::shared_ptr<bool> irq
   );
 
+  [[nodiscard]] auto get_rom() const -> std::span<const u8>; // Whole image, header included
+
   [[nodiscard]] auto prg_read(u16 addr) const -> u8;
   [[nodiscard]] auto chr_read(u16 addr) const -> u8;
 
   void prg_write(u16 addr, u8 value);
   void chr_write(u16 addr, u8 value);
 
-  void scanline_counter() const;
+  // Pre-decoded CHR: a tile row packed as 8 2-bit pixels, leftmost pixel in the top bits.
+  // `addr` may point to either bitplane of the row.
+  [[nodiscard]] auto get_chr_row(u16 addr) -> u16;
+  [[nodiscard]] auto get_chr_row_flipped(u16 addr) -> u16; // Mirrored horizontally
+
+  // Called by the PPU on every rendered scanline, inlined with the mapper's own logic
+  void scanline_counter() {
+    std::visit([](auto& concrete) { concrete.increment_scanline_counter(); }, mapper);
+  }
+
+  [[nodiscard]] auto has_scanline_irq() const -> bool {
+    return std::visit([](const auto& concrete) { return concrete.has_scanline_irq(); }, mapper);
+  }
+
+  // Host pointers to the 256-byte page at `addr`, used by the CPU page table.
+  // nullptr means that the page must go through prg_read/prg_write.
+  [[nodiscard]] auto get_prg_read_page(u16 addr) const -> const u8*;
+  [[nodiscard]] auto get_prg_write_page(u16 addr) -> u8*;
+
+  [[nodiscard]] auto take_prg_map_changed() -> bool;
+
+  // The 1KB pages of nametable memory at $2000, $2400, $2800 and $2C00: the console's CIRAM
+  // arranged by the mirroring, or the cartridge's own VRAM on four-screen boards. To be fetched
+  // again when take_mirroring_changed() returns true.
+  using NametablePages = std::array<u8*, 4>;
+
+  [[nodiscard]] auto get_nametable_pages(std::span<u8, 0x800> ci_ram) -> NametablePages;
+  [[nodiscard]] auto take_mirroring_changed() -> bool;
+
+  // Offset in PRG-ROM of the byte mapped at `addr` (>= 0x8000)
+  [[nodiscard]] auto get_prg_offset(u16 addr) const -> usize;
+  [[nodiscard]] auto get_prg_size() const -> usize;
 
   [[nodiscard]] auto get_prg_ram() const -> std::vector<u8>;
 
+  // PRG-RAM, CHR-RAM and the mapper registers (the ROM itself isn't part of the snapshot)
+  void save(utility::SnapshotWriter& out) const override;
+  void load(utility::SnapshotReader& in) override;
+
 private:
-  Cartridge() = default;
+  Mapper mapper;
+  BaseMapper* base_mapper = &std::get<Mapper0>(mapper); // The shared part of `mapper`
+
+  utility::RomImage rom;
+  std::span<const u8> prg; // In `rom`
+  std::span<u8> chr;       // In `rom`, or `chr_ram`
+  std::vector<u8> chr_ram;
 
-  std::unique_ptr<BaseMapper> mapper;
+  // Decoded CHR, 8 rows (128 bits) per tile and indexed by CHR offset, so bank switching
+  // doesn't invalidate it. 1KB banks are decoded lazily after a CHR write.
+  std::vector<u16> chr_rows;
+  std::vector<u16> chr_rows_flipped;
+  std::vector<bool> chr_bank_dirty;
 
-  std::vector<u8> prg;
-  std::vector<u8> chr;
+  void decode_chr_bank(usize bank);
+  [[nodiscard]] auto get_chr_row_index(u16 addr) -> usize;
 
   std::vector<u8> prg_ram;
+  bool has_chr_ram = false;
+
+  std::vector<u8> vram; // Four-screen boards only, 4KB of nametables instead of CIRAM
 };
 } // namespace nes
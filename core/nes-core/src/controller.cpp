@@ -1,13 +1,9 @@
 #include "controller.hpp"
 
 #include "lib/common.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
-auto Controller::get() -> Controller& {
-  static Controller instance;
-  return instance;
-}
-
 void Controller::update_state(const usize port, const u8 state) {
   controller_state[port] = state;
 }
@@ -38,4 +34,12 @@ auto Controller::peek(const usize port) const -> u8 {
 
   return 0x40 | (controller_bits[port] & 1);
 }
+
+void Controller::save(utility::SnapshotWriter& out) const {
+  dump_snapshot(out, strobe, controller_bits, controller_state);
+}
+
+void Controller::load(utility::SnapshotReader& in) {
+  get_snapshot(in, strobe, controller_bits, controller_state);
+}
 } // namespace nes
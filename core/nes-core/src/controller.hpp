@@ -3,12 +3,11 @@
 #include <array>
 
 #include "lib/common.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
-class Controller final {
+class Controller final: public utility::Snapshotable {
 public:
-  [[nodiscard]] static auto get() -> Controller&;
-
   void update_state(usize port, u8 state);
 
   [[nodiscard]] auto read(usize port) -> u8;
@@ -20,9 +19,10 @@ public:
 
   [[nodiscard]] auto peek(usize port) const -> u8;
 
-private:
-  Controller() = default;
+  void save(utility::SnapshotWriter& out) const override;
+  void load(utility::SnapshotReader& in) override;
 
+private:
   bool strobe = false;                     // Controller strobe latch
   std::array<u8, 2> controller_bits = {};  // Controller shift registers
   std::array<u8, 2> controller_state = {}; // Controller states
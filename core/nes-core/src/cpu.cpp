@@ -1,22 +1,61 @@
 #include "cpu.hpp"
 
+#include <algorithm>
+#include <span>
 #include <stdexcept>
+#include <utility>
 
 #include <spdlog/spdlog.h>
 
+#include "apu.hpp"
 #include "cartridge.hpp"
 #include "controller.hpp"
 #include "lib/common.hpp"
 #include "ppu.hpp"
 #include "types/cpu_types.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
-auto Cpu::get() -> Cpu& {
-  static Cpu instance;
-  return instance;
-}
+namespace {
+#ifdef NES_PPU_CATCH_UP
+  constexpr bool PPU_CATCH_UP = true;
+#else
+  constexpr bool PPU_CATCH_UP = false;
+#endif
+
+#ifdef NES_CPU_IDLE_LOOP_SKIP
+  constexpr bool IDLE_LOOP_SKIP = PPU_CATCH_UP;
+#else
+  constexpr bool IDLE_LOOP_SKIP = false;
+#endif
+
+#ifdef NES_CPU_BLOCK_CACHE
+  constexpr bool BLOCK_CACHE = true;
+#else
+  constexpr bool BLOCK_CACHE = false;
+#endif
+
+#ifdef NES_CPU_TABLE_DISPATCH
+  constexpr auto DEFAULT_DISPATCH = types::cpu::Dispatch::Table;
+#else
+  constexpr auto DEFAULT_DISPATCH = types::cpu::Dispatch::Switch;
+#endif
+} // namespace
+
+Cpu::Cpu(Ppu& ppu_ref, Apu& apu_ref, Cartridge& cartridge_ref, Controller& controller_ref) :
+  ppu(&ppu_ref),
+  apu(&apu_ref),
+  cartridge(&cartridge_ref),
+  controller(&controller_ref),
+  dispatch(DEFAULT_DISPATCH) {}
 
 void Cpu::power_on() {
+  update_page_table();
+
+  if constexpr (BLOCK_CACHE) {
+    reset_block_cache();
+  }
+
   state.a = 0;
   state.x = 0;
   state.y = 0;
@@ -24,9 +63,16 @@ void Cpu::power_on() {
   state.sp = 0xFD;
 
   state.cycle_count = 0;
+  is_odd_frame_start = false;
   state.set_ps(0x34);
   ram.fill(0);
 
+  ppu_pending_dots = 0;
+  ppu_event_dots = 0;
+
+  apu_pending_cycles = 0;
+  apu_event_cycles = 0;
+
   // nestest
   // state.pc          = 0xC000;
   // state.cycle_count = 7;
@@ -36,10 +82,33 @@ void Cpu::reset() {
   INT_RST();
 }
 
-void Cpu::dma_oam(const u16 addr) {
+void Cpu::set_dispatch(const types::cpu::Dispatch value) {
+  dispatch = value;
+}
+
+// The CPU is halted for a cycle, plus one to align with the APU on odd cycles, then a byte is
+// copied every 2 cycles (513 or 514 cycles). Nothing else touches the bus meanwhile, so a page
+// of plain memory is copied at once and the PPU and the APU catch up on the cycles afterwards.
+void Cpu::dma_oam(const u8 page) {
+  const auto is_odd_cycle = ((state.cycle_count & 1) != 0) != is_odd_frame_start;
+  const auto align_cycles = is_odd_cycle ? 2 : 1;
+
+  if (const auto* source = read_pages[page]; source != nullptr) {
+    if constexpr (PPU_CATCH_UP) {
+      ppu_catch_up();
+    }
+
+    ppu->write_oam(std::span<const u8, 0x100>(source, 0x100));
+    halt(align_cycles + 512);
+    return;
+  }
+
+  // Registers, read one by one for their side effects
+  halt(align_cycles);
+
   for (u16 i = 0; i < 256; ++i) {
     // 0x2004 == OAMDATA
-    memory_write(0x2004, memory_read((addr * 0x100) + i));
+    memory_write(0x2004, memory_read(static_cast<u16>((page * 0x100) + i)));
   }
 }
 
@@ -49,38 +118,285 @@ void Cpu::run_frame() {
 
   constexpr auto cycles_per_frame = 29781;
 
+  if (state.cycle_count >= cycles_per_frame) {
+    is_odd_frame_start = !is_odd_frame_start;
+  }
+
   state.cycle_count %= cycles_per_frame;
 
   while (state.cycle_count < cycles_per_frame) {
+    if constexpr (IDLE_LOOP_SKIP) {
+      if (std::exchange(idle_loop_candidate, false)) {
+        skip_idle_loop(cycles_per_frame);
+      }
+    }
+
     if (*nmi) {
       INT_NMI();
-    } else if (*irq && !state.check_flags(Interrupt)) {
+    } else if (irq_line() && !state.check_flags(Interrupt)) {
       INT_IRQ();
     }
 
-    execute();
+    if constexpr (BLOCK_CACHE) {
+      // Code in RAM and PRG-RAM might modify itself, so it is always interpreted
+      if (state.pc >= 0x8000) {
+        run_block(cycles_per_frame);
+        continue;
+      }
+    }
+
+    if (dispatch == types::cpu::Dispatch::Table) {
+      execute<types::cpu::Dispatch::Table>();
+    } else {
+      execute<types::cpu::Dispatch::Switch>();
+    }
+  }
+
+  if constexpr (PPU_CATCH_UP) {
+    ppu_catch_up();
+  }
+
+  apu_catch_up();
+  apu->end_frame();
+}
+
+void Cpu::save(utility::SnapshotWriter& out) const {
+  // Field by field, State has padding
+  dump_snapshot(out, state.a, state.x, state.y, state.pc, state.sp, state.sr, state.ps);
+  dump_snapshot(out, state.nmi_flag, state.irq_flag, state.cycle_count, is_odd_frame_start);
+  dump_snapshot(out, ram, *nmi, *irq, ppu_pending_dots, ppu_event_dots);
+  dump_snapshot(out, apu_pending_cycles, apu_event_cycles);
+}
+
+void Cpu::load(utility::SnapshotReader& in) {
+  get_snapshot(in, state.a, state.x, state.y, state.pc, state.sp, state.sr, state.ps);
+  get_snapshot(in, state.nmi_flag, state.irq_flag, state.cycle_count, is_odd_frame_start);
+  get_snapshot(in, ram, *nmi, *irq, ppu_pending_dots, ppu_event_dots);
+  get_snapshot(in, apu_pending_cycles, apu_event_cycles);
+
+  // The cartridge is restored first, so the PRG banks are already in place
+  update_page_table();
+}
+
+void Cpu::ppu_catch_up() {
+  ppu->run(ppu_pending_dots);
+  ppu_pending_dots = 0;
+  ppu_event_dots = ppu->dots_until_event();
+}
+
+void Cpu::apu_catch_up() {
+  apu->run(apu_pending_cycles);
+  apu_pending_cycles = 0;
+  apu_event_cycles = apu->cycles_until_irq();
+}
+
+// Skips whole iterations of the idle loop at PC, if any. Every skipped iteration must behave
+// exactly like the last one: its reads have no side effects left to apply and its ticks can't
+// reach the next PPU or APU event (which would catch up and maybe raise an interrupt).
+// The loop resumes at its first instruction, so the registers are reloaded as usual.
+void Cpu::skip_idle_loop(const i32 end_cycle) {
+  if (interrupt_pending()) {
+    return;
+  }
+
+  const auto cycles = get_idle_loop_cycles();
+
+  if (cycles == 0) {
+    return;
+  }
+
+  const auto until_event = (ppu_event_dots - ppu_pending_dots - 1) / (cycles * 3);
+  const auto until_apu_event = (apu_event_cycles - apu_pending_cycles - 1) / cycles;
+  const auto until_frame_end = (end_cycle - state.cycle_count) / cycles;
+  const auto iterations = std::min({until_event, until_apu_event, until_frame_end});
+
+  if (iterations <= 0) {
+    return;
+  }
+
+  state.cycle_count += iterations * cycles;
+  ppu_pending_dots += iterations * cycles * 3;
+  apu_pending_cycles += iterations * cycles;
+}
+
+// Returns the cycles taken by an iteration of the idle loop starting at PC, or 0 if there is none.
+// Recognised loops:
+// - JMP *
+// - LDA/BIT on RAM followed by BPL/BMI/BNE/BEQ back to it, taken with the current value
+// - LDA/BIT $2002 followed by BPL back to it while VBlank is clear, which stays clear until the
+//   next PPU event
+auto Cpu::get_idle_loop_cycles() const -> i32 {
+  const auto pc = state.pc;
+  const auto opcode = peek(pc);
+
+  const auto read_addr = [&](const u16 offset) {
+    return static_cast<u16>((peek(pc + offset + 1) << 8) | peek(pc + offset));
+  };
+
+  if (opcode == 0x4C) { // JMP
+    return read_addr(1) == pc ? 3 : 0;
+  }
+
+  u16 addr = 0;
+  u16 length = 0;
+  i32 cycles = 0;
+
+  switch (opcode) {
+    case 0x24:   // BIT zero page
+    case 0xA5: { // LDA zero page
+      addr = peek(pc + 1);
+      length = 2;
+      cycles = 3;
+      break;
+    }
+
+    case 0x2C:   // BIT absolute
+    case 0xAD: { // LDA absolute
+      addr = read_addr(1);
+      length = 3;
+      cycles = 4;
+      break;
+    }
+
+    default: return 0;
+  }
+
+  const auto branch_pc = static_cast<u16>(pc + length);
+  const auto branch_opcode = peek(branch_pc);
+  const auto next_pc = static_cast<u16>(branch_pc + 2);
+
+  if (static_cast<u16>(next_pc + static_cast<i8>(peek(branch_pc + 1))) != pc) {
+    return 0;
+  }
+
+  const bool is_ram = addr < 0x2000;
+  const bool is_ppu_status = addr >= 0x2000 && addr < 0x4000 && (addr & 0x07) == 0x02;
+
+  if (!is_ram && !is_ppu_status) {
+    return 0;
+  }
+
+  const auto value = peek(addr);
+  const bool negative = (value & 0x80) != 0;
+  const bool zero = (opcode == 0x24 || opcode == 0x2C) ? (state.a & value) == 0 : value == 0;
+
+  bool taken = false;
+
+  switch (branch_opcode) {
+    case 0x10: taken = !negative; break;               // BPL
+    case 0x30: taken = negative && is_ram; break;      // BMI, reading $2002 clears VBlank
+    case 0xD0: taken = !zero && is_ram; break;         // BNE, the sprite flags may change
+    case 0xF0: taken = zero && is_ram; break;          // BEQ
+    default: return 0;
+  }
+
+  if (!taken) {
+    return 0;
   }
+
+  return cycles + 3 + (will_cross_page(next_pc, pc) ? 1 : 0);
 }
 
 void Cpu::tick() {
-  Ppu::get().step();
-  Ppu::get().step();
-  Ppu::get().step();
+  if constexpr (PPU_CATCH_UP) {
+    ppu_pending_dots += 3;
+
+    if (ppu_pending_dots >= ppu_event_dots) {
+      ppu_catch_up();
+    }
+  } else {
+    ppu->step();
+    ppu->step();
+    ppu->step();
+  }
+
+  if (++apu_pending_cycles >= apu_event_cycles) {
+    apu_catch_up();
+  }
+
   ++state.cycle_count;
 }
 
+// OAM DMA halts the CPU through here, and so would the DMC sample fetches once their stalls are
+// emulated. The PPU and the APU run the cycles at once, their interrupts are only polled by the
+// next instruction anyway.
+void Cpu::halt(const i32 cycles) {
+  if constexpr (PPU_CATCH_UP) {
+    ppu_pending_dots += cycles * 3;
+
+    if (ppu_pending_dots >= ppu_event_dots) {
+      ppu_catch_up();
+    }
+  } else {
+    ppu->run(cycles * 3);
+  }
+
+  apu_pending_cycles += cycles;
+
+  if (apu_pending_cycles >= apu_event_cycles) {
+    apu_catch_up();
+  }
+
+  state.cycle_count += cycles;
+}
+
+auto Cpu::irq_line() const -> bool {
+  return *irq || apu->has_irq();
+}
+
+auto Cpu::interrupt_pending() const -> bool {
+  return *nmi || (irq_line() && !state.check_flags(types::cpu::Flags::Interrupt));
+}
+
+void Cpu::update_page_table() {
+  for (usize page = 0x00; page < 0x20; ++page) {
+    // 2KB internal RAM mirrored up to 0x1FFF
+    auto* ram_page = &ram[(page & 0x07) * 0x100];
+    read_pages[page] = ram_page;
+    write_pages[page] = ram_page;
+  }
+
+  for (usize page = 0x20; page < 0x60; ++page) {
+    // PPU, APU and I/O registers
+    read_pages[page] = nullptr;
+    write_pages[page] = nullptr;
+  }
+
+  for (usize page = 0x60; page < 0x80; ++page) {
+    const auto addr = static_cast<u16>(page * 0x100);
+    read_pages[page] = cartridge->get_prg_read_page(addr);
+    write_pages[page] = cartridge->get_prg_write_page(addr);
+  }
+
+  update_prg_pages();
+}
+
+void Cpu::update_prg_pages() {
+  for (usize page = 0x80; page < 0x100; ++page) {
+    const auto addr = static_cast<u16>(page * 0x100);
+    read_pages[page] = cartridge->get_prg_read_page(addr);
+    write_pages[page] = nullptr; // Mapper registers
+  }
+
+  ++prg_map_generation;
+}
+
 auto Cpu::peek(u16 addr) const -> u8 {
   using types::cpu::memory::get_map;
   using enum types::cpu::memory::MemoryMap;
   using enum types::cpu::memory::Operation;
 
+  if (const auto* page = read_pages[addr >> 8]; page != nullptr) {
+    return page[addr & 0xFF];
+  }
+
   switch (get_map<Read>(addr)) {
     case CpuRam: return ram[addr & 0x07FF];
-    case PpuAccess: return Ppu::get().peek_reg(addr);
+    case PpuAccess: return ppu->peek_reg(addr);
     case ApuAccess: return 0xFF; // Avoids APU side effects and satisfies nestest
-    case Controller1: return Controller::get().peek(0);
-    case Controller2: return Controller::get().peek(1);
-    case CartridgeAccess: return Cartridge::get().prg_read(addr);
+    case Controller1: return controller->peek(0);
+    case Controller2: return controller->peek(1);
+    case CartridgeAccess: return cartridge->prg_read(addr);
 
     case OamDma:
     case ControllerAccess:
@@ -90,18 +406,32 @@ auto Cpu::peek(u16 addr) const -> u8 {
   }
 }
 
-auto Cpu::read(u16 addr) const -> u8 {
+auto Cpu::read(u16 addr) -> u8 {
   using types::cpu::memory::get_map;
   using enum types::cpu::memory::MemoryMap;
   using enum types::cpu::memory::Operation;
 
+  if (const auto* page = read_pages[addr >> 8]; page != nullptr) {
+    return page[addr & 0xFF];
+  }
+
   switch (get_map<Read>(addr)) {
     case CpuRam: return ram[addr & 0x07FF];
-    case PpuAccess: return Ppu::get().read(addr);
-    case ApuAccess: return 0;
-    case Controller1: return Controller::get().read(0);
-    case Controller2: return Controller::get().read(1);
-    case CartridgeAccess: return Cartridge::get().prg_read(addr);
+    case PpuAccess:
+      if constexpr (PPU_CATCH_UP) {
+        ppu_catch_up();
+      }
+      return ppu->read(addr);
+    case ApuAccess:
+      if (addr != 0x4015) {
+        return 0; // Write-only registers
+      }
+
+      apu_catch_up();
+      return apu->read_status();
+    case Controller1: return controller->read(0);
+    case Controller2: return controller->read(1);
+    case CartridgeAccess: return cartridge->prg_read(addr);
 
     case OamDma:
     case ControllerAccess:
@@ -116,13 +446,50 @@ void Cpu::write(const u16 addr, const u8 value) {
   using enum types::cpu::memory::MemoryMap;
   using enum types::cpu::memory::Operation;
 
+  if (auto* page = write_pages[addr >> 8]; page != nullptr) {
+    page[addr & 0xFF] = value;
+    return;
+  }
+
   switch (get_map<Write>(addr)) {
     case CpuRam: ram[addr & 0x07FF] = value; break;
-    case PpuAccess: Ppu::get().write(addr, value); break;
-    case ApuAccess: break;
+    case PpuAccess:
+      if constexpr (PPU_CATCH_UP) {
+        ppu_catch_up();
+      }
+
+      ppu->write(addr, value);
+
+      if constexpr (PPU_CATCH_UP) {
+        ppu_event_dots = ppu->dots_until_event(); // NMI or rendering might have been toggled
+      }
+      break;
+    case ApuAccess:
+      apu_catch_up();
+      apu->write(addr, value);
+      apu_event_cycles = apu->cycles_until_irq(); // The IRQ might have been toggled
+      break;
     case OamDma: dma_oam(value); break;
-    case ControllerAccess: Controller::get().write((value & 1) != 0); break;
-    case CartridgeAccess: Cartridge::get().prg_write(addr, value); break;
+    case ControllerAccess: controller->write((value & 1) != 0); break;
+    case CartridgeAccess:
+      if constexpr (PPU_CATCH_UP) {
+        ppu_catch_up(); // The mapper might switch CHR banks or mirroring
+      }
+
+      cartridge->prg_write(addr, value);
+
+      if (cartridge->take_prg_map_changed()) {
+        update_prg_pages();
+      }
+
+      if (cartridge->take_mirroring_changed()) {
+        ppu->update_nametables();
+      }
+
+      if constexpr (PPU_CATCH_UP) {
+        ppu_event_dots = ppu->dots_until_event(); // The scanline IRQ might have been toggled
+      }
+      break;
 
     case Controller1:
     case Controller2:
@@ -146,6 +513,10 @@ auto Cpu::get_state() const -> types::cpu::State {
   return state;
 }
 
+auto Cpu::get_ram() const -> const RamType& {
+  return ram;
+}
+
 auto Cpu::peek_imm() const -> u16 {
   return state.pc + 1;
 }
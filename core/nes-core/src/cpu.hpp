@@ -2,24 +2,37 @@
 
 #include <array>
 #include <memory>
+#include <vector>
 
 #include "lib/common.hpp"
 #include "types/cpu_types.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
-class Cpu final {
+class Apu;
+class Cartridge;
+class Controller;
+class Ppu;
+
+class Cpu final: public utility::Snapshotable {
 public:
   using RamType = std::array<u8, 0x800>;
 
-  [[nodiscard]] static auto get() -> Cpu&;
+  Cpu(Ppu& ppu_ref, Apu& apu_ref, Cartridge& cartridge_ref, Controller& controller_ref);
 
   void power_on();
   void reset();
 
-  void dma_oam(u16 addr);
+  void set_dispatch(types::cpu::Dispatch value);
+
+  void dma_oam(u8 page);
 
   void run_frame();
 
+  // Registers, RAM and the interrupt lines
+  void save(utility::SnapshotWriter& out) const override;
+  void load(utility::SnapshotReader& in) override;
+
   std::shared_ptr<bool> irq;
   std::shared_ptr<bool> nmi;
 
@@ -28,6 +41,7 @@ public:
   //
 
   [[nodiscard]] auto get_state() const -> types::cpu::State;
+  [[nodiscard]] auto get_ram() const -> const RamType&;
 
   [[nodiscard]] auto peek(u16 addr) const -> u8;
 
@@ -44,14 +58,74 @@ public:
   [[nodiscard]] auto peek_indy() const -> u16;
 
 private:
-  Cpu() = default;
+  using Handler = void (*)(Cpu&);
+
+  Ppu* ppu;
+  Apu* apu;
+  Cartridge* cartridge;
+  Controller* controller;
 
   types::cpu::State state;
   RamType ram = {};
 
+  types::cpu::Dispatch dispatch; // ENABLE_CPU_TABLE_DISPATCH selects the default
+
+  // One entry per 256-byte page: pages backed by plain memory (RAM, PRG-RAM and PRG-ROM)
+  // are accessed through a host pointer, nullptr pages go through the memory map handlers
+  std::array<const u8*, 0x100> read_pages = {};
+  std::array<u8*, 0x100> write_pages = {};
+
+  void update_page_table();
+  void update_prg_pages();
+
+  // Catch-up PPU (ENABLE_PPU_CATCH_UP): the PPU only runs when the CPU accesses it,
+  // when it may raise an interrupt or at the end of the frame
+  i32 ppu_pending_dots = 0; // Dots the PPU is behind the CPU
+  i32 ppu_event_dots = 0;   // Dots until the PPU may raise an NMI or an IRQ
+
+  void ppu_catch_up();
+
+  // The APU is always caught up: it runs when the CPU accesses it, when it may raise an IRQ
+  // and at the end of the frame
+  i32 apu_pending_cycles = 0; // Cycles the APU is behind the CPU
+  i32 apu_event_cycles = 0;   // Cycles until the APU may raise an IRQ
+
+  void apu_catch_up();
+
+  // Idle loop skipping (ENABLE_CPU_IDLE_LOOP_SKIP, requires the catch-up PPU): iterations of a
+  // polling loop whose outcome can't change before the next PPU event are skipped at once
+  bool idle_loop_candidate = false; // Set by jumps and branches that may close an idle loop
+
+  void skip_idle_loop(i32 end_cycle);
+  [[nodiscard]] auto get_idle_loop_cycles() const -> i32;
+
+  //
+  // Block cache (ENABLE_CPU_BLOCK_CACHE), implemented in cpu_block_cache.cpp
+  //
+
+  // Straight-line PRG-ROM code is decoded once into a run of handlers ending with nullptr.
+  // Blocks are keyed by PRG-ROM offset, i.e. by mapped bank and PC.
+  std::vector<Handler> block_code;
+  std::vector<u32> block_lookup; // PRG-ROM offset -> index in block_code, 0 if not decoded yet
+  u32 prg_map_generation = 0;    // Incremented when the PRG banks are switched
+
+  void reset_block_cache();
+  void run_block(i32 end_cycle);
+  void decode_block(usize offset, i32 end_cycle);
+
+  [[nodiscard]] static auto ends_block(u8 opcode) -> bool;
+
+  // Frames have an odd number of cycles, so the parity of the cycles since power on also
+  // depends on the frames run so far (the DMA alignment cycle needs it)
+  bool is_odd_frame_start = false;
+
   void tick();
+  void halt(i32 cycles); // DMA: cycles where the CPU is halted while the PPU and the APU run
+
+  [[nodiscard]] auto irq_line() const -> bool; // Cartridge or APU
+  [[nodiscard]] auto interrupt_pending() const -> bool;
 
-  [[nodiscard]] auto read(u16 addr) const -> u8;
+  [[nodiscard]] auto read(u16 addr) -> u8;
   void write(u16 addr, u8 value);
 
   [[nodiscard]] auto memory_read(u16 addr) -> u8;
@@ -62,8 +136,17 @@ private:
   // implemented in cpu_instructions.cpp
   //
 
+  template <auto Dispatch>
   void execute();
 
+  // Calls `visit` with a stateless callable that executes `opcode` on a given Cpu
+  template <typename Visitor>
+  static constexpr auto decode(u8 opcode, Visitor visit);
+
+  [[nodiscard]] static auto get_handler(u8 opcode) -> Handler;
+
+  void invalid_opcode();
+
   // Instructions
 
   //
@@ -0,0 +1,90 @@
+#include "cpu.hpp"
+
+#include "cartridge.hpp"
+#include "lib/common.hpp"
+#include "types/cpu_types.hpp"
+
+namespace nes {
+using enum types::cpu::AddressingMode;
+
+namespace {
+  constexpr usize max_block_size = 64;
+  constexpr u16 prg_slot_mask = 0xE000; // 8KB banks
+} // namespace
+
+void Cpu::reset_block_cache() {
+  block_code.assign(1, nullptr); // Index 0 means "not decoded yet"
+  block_lookup.assign(cartridge->get_prg_size(), 0);
+}
+
+// Runs the block starting at PC, which must be in PRG-ROM.
+// Between instructions it stops at the same points where the interpreter loop would do
+// something other than executing the next instruction: end of the frame, pending interrupt
+// or a PRG bank switch that may have changed the code after PC.
+void Cpu::run_block(const i32 end_cycle) {
+  const auto offset = cartridge->get_prg_offset(state.pc);
+
+  if (block_lookup[offset] == 0) {
+    decode_block(offset, end_cycle);
+    return;
+  }
+
+  const auto generation = prg_map_generation;
+  const auto* handler = &block_code[block_lookup[offset]];
+
+  do {
+    // Opcode fetch, the opcode is already known and PRG-ROM reads have no side effects
+    tick();
+    ++state.pc;
+
+    (*handler)(*this);
+    ++handler;
+  } while (*handler != nullptr && state.cycle_count < end_cycle &&
+           generation == prg_map_generation && !interrupt_pending());
+}
+
+// Executes instructions like the interpreter while recording their handlers.
+// A block cut short by the end of the frame or by an interrupt is dropped and decoded again
+// the next time, so that every block runs up to its natural end.
+void Cpu::decode_block(const usize offset, const i32 end_cycle) {
+  const auto start = block_code.size();
+  const auto slot = state.pc & prg_slot_mask;
+  const auto generation = prg_map_generation;
+
+  while (true) {
+    const u8 opcode = memory_read(get_operand<Immediate>());
+    const auto handler = get_handler(opcode);
+
+    handler(*this);
+    block_code.push_back(handler);
+
+    if (ends_block(opcode) || generation != prg_map_generation ||
+        (state.pc & prg_slot_mask) != slot || block_code.size() - start == max_block_size) {
+      break;
+    }
+
+    if (state.cycle_count >= end_cycle || interrupt_pending()) {
+      block_code.resize(start);
+      return;
+    }
+  }
+
+  block_code.push_back(nullptr);
+  block_lookup[offset] = static_cast<u32>(start);
+}
+
+auto Cpu::ends_block(const u8 opcode) -> bool {
+  switch (opcode) {
+    case 0x00: // BRK
+    case 0x20: // JSR
+    case 0x40: // RTI
+    case 0x4C: // JMP
+    case 0x60: // RTS
+    case 0x6C: // JMP (indirect)
+      return true;
+
+    // Branches: BPL, BMI, BVC, BVS, BCC, BCS, BNE, BEQ
+    default: return (opcode & 0x1F) == 0x10;
+  }
+}
+} // namespace nes
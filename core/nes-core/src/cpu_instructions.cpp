@@ -1,5 +1,6 @@
 #include "cpu.hpp"
 
+#include <array>
 #include <format>
 #include <stdexcept>
 #include <utility>
@@ -54,296 +55,6 @@ auto Cpu::get_operand<IndirectY>() -> u16;
 template <>
 auto Cpu::get_operand<IndirectY_Exception>() -> u16;
 
-void Cpu::execute() {
-  u8 opcode = memory_read(get_operand<Immediate>());
-
-  switch (opcode) {
-    case 0x00: return INT_BRK();
-    case 0x01: return ORA<IndirectX>();
-    case 0x05: return ORA<ZeroPage>();
-    case 0x06: return ASL<ZeroPage>();
-    case 0x08: return PHP();
-    case 0x09: return ORA<Immediate>();
-    case 0x0A: return ASL<Accumulator>();
-    case 0x0D: return ORA<Absolute>();
-    case 0x0E: return ASL<Absolute>();
-    case 0x10: return BPL();
-    case 0x11: return ORA<IndirectY>();
-    case 0x15: return ORA<ZeroPageX>();
-    case 0x16: return ASL<ZeroPageX>();
-    case 0x18: return CLC();
-    case 0x19: return ORA<AbsoluteY>();
-    case 0x1D: return ORA<AbsoluteX>();
-    case 0x1E: return ASL<AbsoluteX_Exception>();
-    case 0x20: return JSR();
-    case 0x21: return AND<IndirectX>();
-    case 0x24: return BIT<ZeroPage>();
-    case 0x25: return AND<ZeroPage>();
-    case 0x26: return ROL<ZeroPage>();
-    case 0x28: return PLP();
-    case 0x29: return AND<Immediate>();
-    case 0x2A: return ROL<Accumulator>();
-    case 0x2C: return BIT<Absolute>();
-    case 0x2D: return AND<Absolute>();
-    case 0x2E: return ROL<Absolute>();
-    case 0x30: return BMI();
-    case 0x31: return AND<IndirectY>();
-    case 0x35: return AND<ZeroPageX>();
-    case 0x36: return ROL<ZeroPageX>();
-    case 0x38: return SEC();
-    case 0x39: return AND<AbsoluteY>();
-    case 0x3D: return AND<AbsoluteX>();
-    case 0x3E: return ROL<AbsoluteX_Exception>();
-    case 0x40: return RTI();
-    case 0x41: return EOR<IndirectX>();
-    case 0x45: return EOR<ZeroPage>();
-    case 0x46: return LSR<ZeroPage>();
-    case 0x48: return PHA();
-    case 0x49: return EOR<Immediate>();
-    case 0x4A: return LSR<Accumulator>();
-    case 0x4C: return JMP<Absolute>();
-    case 0x4D: return EOR<Absolute>();
-    case 0x4E: return LSR<Absolute>();
-    case 0x50: return BVC();
-    case 0x51: return EOR<IndirectY>();
-    case 0x55: return EOR<ZeroPageX>();
-    case 0x56: return LSR<ZeroPageX>();
-    case 0x58: return CLI();
-    case 0x59: return EOR<AbsoluteY>();
-    case 0x5D: return EOR<AbsoluteX>();
-    case 0x5E: return LSR<AbsoluteX_Exception>();
-    case 0x60: return RTS();
-    case 0x61: return ADC<IndirectX>();
-    case 0x65: return ADC<ZeroPage>();
-    case 0x66: return ROR<ZeroPage>();
-    case 0x68: return PLA();
-    case 0x69: return ADC<Immediate>();
-    case 0x6A: return ROR<Accumulator>();
-    case 0x6C: return JMP<Indirect>();
-    case 0x6D: return ADC<Absolute>();
-    case 0x6E: return ROR<Absolute>();
-    case 0x70: return BVS();
-    case 0x71: return ADC<IndirectY>();
-    case 0x75: return ADC<ZeroPageX>();
-    case 0x76: return ROR<ZeroPageX>();
-    case 0x78: return SEI();
-    case 0x79: return ADC<AbsoluteY>();
-    case 0x7D: return ADC<AbsoluteX>();
-    case 0x7E: return ROR<AbsoluteX_Exception>();
-    case 0x81: return STA<IndirectX>();
-    case 0x84: return STY<ZeroPage>();
-    case 0x85: return STA<ZeroPage>();
-    case 0x86: return STX<ZeroPage>();
-    case 0x88: return DEY();
-    case 0x8A: return TXA();
-    case 0x8C: return STY<Absolute>();
-    case 0x8D: return STA<Absolute>();
-    case 0x8E: return STX<Absolute>();
-    case 0x90: return BCC();
-    case 0x91: return STA<IndirectY_Exception>();
-    case 0x94: return STY<ZeroPageX>();
-    case 0x95: return STA<ZeroPageX>();
-    case 0x96: return STX<ZeroPageY>();
-    case 0x98: return TYA();
-    case 0x99: return STA<AbsoluteY_Exception>();
-    case 0x9A: return TXS();
-    case 0x9D: return STA<AbsoluteX_Exception>();
-    case 0xA0: return LDY<Immediate>();
-    case 0xA1: return LDA<IndirectX>();
-    case 0xA2: return LDX<Immediate>();
-    case 0xA4: return LDY<ZeroPage>();
-    case 0xA5: return LDA<ZeroPage>();
-    case 0xA6: return LDX<ZeroPage>();
-    case 0xA8: return TAY();
-    case 0xA9: return LDA<Immediate>();
-    case 0xAA: return TAX();
-    case 0xAC: return LDY<Absolute>();
-    case 0xAD: return LDA<Absolute>();
-    case 0xAE: return LDX<Absolute>();
-    case 0xB0: return BCS();
-    case 0xB1: return LDA<IndirectY>();
-    case 0xB4: return LDY<ZeroPageX>();
-    case 0xB5: return LDA<ZeroPageX>();
-    case 0xB6: return LDX<ZeroPageY>();
-    case 0xB8: return CLV();
-    case 0xB9: return LDA<AbsoluteY>();
-    case 0xBA: return TSX();
-    case 0xBC: return LDY<AbsoluteX>();
-    case 0xBD: return LDA<AbsoluteX>();
-    case 0xBE: return LDX<AbsoluteY>();
-    case 0xC0: return CPY<Immediate>();
-    case 0xC1: return CMP<IndirectX>();
-    case 0xC4: return CPY<ZeroPage>();
-    case 0xC5: return CMP<ZeroPage>();
-    case 0xC6: return DEC<ZeroPage>();
-    case 0xC8: return INY();
-    case 0xC9: return CMP<Immediate>();
-    case 0xCA: return DEX();
-    case 0xCC: return CPY<Absolute>();
-    case 0xCD: return CMP<Absolute>();
-    case 0xCE: return DEC<Absolute>();
-    case 0xD0: return BNE();
-    case 0xD1: return CMP<IndirectY>();
-    case 0xD5: return CMP<ZeroPageX>();
-    case 0xD6: return DEC<ZeroPageX>();
-    case 0xD8: return CLD();
-    case 0xD9: return CMP<AbsoluteY>();
-    case 0xDD: return CMP<AbsoluteX>();
-    case 0xDE: return DEC<AbsoluteX_Exception>();
-    case 0xE0: return CPX<Immediate>();
-    case 0xE1: return SBC<IndirectX>();
-    case 0xE4: return CPX<ZeroPage>();
-    case 0xE5: return SBC<ZeroPage>();
-    case 0xE6: return INC<ZeroPage>();
-    case 0xE8: return INX();
-    case 0xE9: return SBC<Immediate>();
-    case 0xEA: return NOP();
-    case 0xEC: return CPX<Absolute>();
-    case 0xED: return SBC<Absolute>();
-    case 0xEE: return INC<Absolute>();
-    case 0xF0: return BEQ();
-    case 0xF1: return SBC<IndirectY>();
-    case 0xF5: return SBC<ZeroPageX>();
-    case 0xF6: return INC<ZeroPageX>();
-    case 0xF8: return SED();
-    case 0xF9: return SBC<AbsoluteY>();
-    case 0xFD: return SBC<AbsoluteX>();
-    case 0xFE: return INC<AbsoluteX_Exception>();
-
-    //
-    // Unofficial instructions
-    //
-
-    // NOP
-    case 0x04:
-    case 0x44:
-    case 0x64: return NOP<ZeroPage>();
-    case 0x0C: return NOP<Absolute>();
-    case 0x14:
-    case 0x34:
-    case 0x54:
-    case 0x74:
-    case 0xD4:
-    case 0xF4: return NOP<ZeroPageX>();
-    case 0x1A:
-    case 0x3A:
-    case 0x5A:
-    case 0x7A:
-    case 0xDA:
-    case 0xFA: return NOP();
-    case 0x80:
-    case 0x82:
-    case 0x89:
-    case 0xC2:
-    case 0xE2: return NOP<Immediate>();
-    case 0x1C:
-    case 0x3C:
-    case 0x5C:
-    case 0x7C:
-    case 0xDC:
-    case 0xFC: return NOP<AbsoluteX>();
-
-    // LAX
-    case 0xA3: return LAX<IndirectX>();
-    case 0xA7: return LAX<ZeroPage>();
-    case 0xAF: return LAX<Absolute>();
-    case 0xB3: return LAX<IndirectY>();
-    case 0xB7: return LAX<ZeroPageY>();
-    case 0xBF: return LAX<AbsoluteY>();
-
-    // SAX
-    case 0x83: return SAX<IndirectX>();
-    case 0x87: return SAX<ZeroPage>();
-    case 0x8F: return SAX<Absolute>();
-    case 0x97: return SAX<ZeroPageY>();
-
-    // SBC
-    case 0xEB: return SBC<Immediate>();
-
-    // DCP
-    case 0xC3: return DCP<IndirectX>();
-    case 0xC7: return DCP<ZeroPage>();
-    case 0xCF: return DCP<Absolute>();
-    case 0xD3: return DCP<IndirectY>();
-    case 0xD7: return DCP<ZeroPageX>();
-    case 0xDB: return DCP<AbsoluteY>();
-    case 0xDF: return DCP<AbsoluteX>();
-
-    // ISB
-    case 0xE3: return ISB<IndirectX>();
-    case 0xE7: return ISB<ZeroPage>();
-    case 0xEF: return ISB<Absolute>();
-    case 0xF3: return ISB<IndirectY>();
-    case 0xF7: return ISB<ZeroPageX>();
-    case 0xFB: return ISB<AbsoluteY>();
-    case 0xFF: return ISB<AbsoluteX>();
-
-    // SLO
-    case 0x03: return SLO<IndirectX>();
-    case 0x07: return SLO<ZeroPage>();
-    case 0x0F: return SLO<Absolute>();
-    case 0x13: return SLO<IndirectY>();
-    case 0x17: return SLO<ZeroPageX>();
-    case 0x1B: return SLO<AbsoluteY>();
-    case 0x1F: return SLO<AbsoluteX>();
-
-    // RLA
-    case 0x23: return RLA<IndirectX>();
-    case 0x27: return RLA<ZeroPage>();
-    case 0x2F: return RLA<Absolute>();
-    case 0x33: return RLA<IndirectY>();
-    case 0x37: return RLA<ZeroPageX>();
-    case 0x3B: return RLA<AbsoluteY>();
-    case 0x3F: return RLA<AbsoluteX>();
-
-    // SRE
-    case 0x43: return SRE<IndirectX>();
-    case 0x47: return SRE<ZeroPage>();
-    case 0x4F: return SRE<Absolute>();
-    case 0x53: return SRE<IndirectY>();
-    case 0x57: return SRE<ZeroPageX>();
-    case 0x5B: return SRE<AbsoluteY>();
-    case 0x5F: return SRE<AbsoluteX>();
-
-    // RRA
-    case 0x63: return RRA<IndirectX>();
-    case 0x67: return RRA<ZeroPage>();
-    case 0x6F: return RRA<Absolute>();
-    case 0x73: return RRA<IndirectY>();
-    case 0x77: return RRA<ZeroPageX>();
-    case 0x7B: return RRA<AbsoluteY>();
-    case 0x7F: return RRA<AbsoluteX>();
-
-    // AAC
-    case 0x0B:
-    case 0x2B: return AAC<Immediate>();
-
-    // ASR
-    case 0x4B: return ASR<Immediate>();
-
-    // ARR
-    case 0x6B: return ARR<Immediate>();
-
-    // ATX
-    case 0xAB: return ATX<Immediate>();
-
-    // AXS
-    case 0xCB: return AXS<Immediate>();
-
-    // SYA
-    case 0x9C: return SYA<AbsoluteX_Exception>();
-
-    // SXA
-    case 0x9E: return SXA<AbsoluteY_Exception>();
-
-    default: {
-      const auto error_message = std::format("Invalid opcode: 0x{:02X}", opcode);
-      spdlog::error(error_message);
-      throw std::runtime_error(error_message);
-    }
-  }
-}
-
 /* Instructions */
 
 //
@@ -443,6 +154,9 @@ void Cpu::branch(const bool taken) {
 
   tick();
 
+  // Polling loops are a load followed by a branch back to it
+  idle_loop_candidate = static_cast<u16>(state.pc - jump_addr) <= 5;
+
   state.pc = jump_addr;
 }
 
@@ -811,7 +525,13 @@ void Cpu::BIT() {
 
 template <auto Mode>
 void Cpu::JMP() {
-  state.set_pc(get_operand<Mode>());
+  const auto addr = get_operand<Mode>();
+
+  if constexpr (Mode == Absolute) {
+    idle_loop_candidate = static_cast<u16>(state.pc - addr) == 3; // JMP *
+  }
+
+  state.set_pc(addr);
 }
 
 void Cpu::JSR() {
@@ -1313,4 +1033,332 @@ auto Cpu::get_operand<IndirectY_Exception>() -> u16 {
 
   return base_addr + state.y;
 }
+
+//
+// Dispatch
+//
+
+template <typename Visitor>
+constexpr auto Cpu::decode(const u8 opcode, Visitor visit) {
+  switch (opcode) {
+    case 0x00: return visit([](Cpu& cpu) { cpu.INT_BRK(); });
+    case 0x01: return visit([](Cpu& cpu) { cpu.ORA<IndirectX>(); });
+    case 0x05: return visit([](Cpu& cpu) { cpu.ORA<ZeroPage>(); });
+    case 0x06: return visit([](Cpu& cpu) { cpu.ASL<ZeroPage>(); });
+    case 0x08: return visit([](Cpu& cpu) { cpu.PHP(); });
+    case 0x09: return visit([](Cpu& cpu) { cpu.ORA<Immediate>(); });
+    case 0x0A: return visit([](Cpu& cpu) { cpu.ASL<Accumulator>(); });
+    case 0x0D: return visit([](Cpu& cpu) { cpu.ORA<Absolute>(); });
+    case 0x0E: return visit([](Cpu& cpu) { cpu.ASL<Absolute>(); });
+    case 0x10: return visit([](Cpu& cpu) { cpu.BPL(); });
+    case 0x11: return visit([](Cpu& cpu) { cpu.ORA<IndirectY>(); });
+    case 0x15: return visit([](Cpu& cpu) { cpu.ORA<ZeroPageX>(); });
+    case 0x16: return visit([](Cpu& cpu) { cpu.ASL<ZeroPageX>(); });
+    case 0x18: return visit([](Cpu& cpu) { cpu.CLC(); });
+    case 0x19: return visit([](Cpu& cpu) { cpu.ORA<AbsoluteY>(); });
+    case 0x1D: return visit([](Cpu& cpu) { cpu.ORA<AbsoluteX>(); });
+    case 0x1E: return visit([](Cpu& cpu) { cpu.ASL<AbsoluteX_Exception>(); });
+    case 0x20: return visit([](Cpu& cpu) { cpu.JSR(); });
+    case 0x21: return visit([](Cpu& cpu) { cpu.AND<IndirectX>(); });
+    case 0x24: return visit([](Cpu& cpu) { cpu.BIT<ZeroPage>(); });
+    case 0x25: return visit([](Cpu& cpu) { cpu.AND<ZeroPage>(); });
+    case 0x26: return visit([](Cpu& cpu) { cpu.ROL<ZeroPage>(); });
+    case 0x28: return visit([](Cpu& cpu) { cpu.PLP(); });
+    case 0x29: return visit([](Cpu& cpu) { cpu.AND<Immediate>(); });
+    case 0x2A: return visit([](Cpu& cpu) { cpu.ROL<Accumulator>(); });
+    case 0x2C: return visit([](Cpu& cpu) { cpu.BIT<Absolute>(); });
+    case 0x2D: return visit([](Cpu& cpu) { cpu.AND<Absolute>(); });
+    case 0x2E: return visit([](Cpu& cpu) { cpu.ROL<Absolute>(); });
+    case 0x30: return visit([](Cpu& cpu) { cpu.BMI(); });
+    case 0x31: return visit([](Cpu& cpu) { cpu.AND<IndirectY>(); });
+    case 0x35: return visit([](Cpu& cpu) { cpu.AND<ZeroPageX>(); });
+    case 0x36: return visit([](Cpu& cpu) { cpu.ROL<ZeroPageX>(); });
+    case 0x38: return visit([](Cpu& cpu) { cpu.SEC(); });
+    case 0x39: return visit([](Cpu& cpu) { cpu.AND<AbsoluteY>(); });
+    case 0x3D: return visit([](Cpu& cpu) { cpu.AND<AbsoluteX>(); });
+    case 0x3E: return visit([](Cpu& cpu) { cpu.ROL<AbsoluteX_Exception>(); });
+    case 0x40: return visit([](Cpu& cpu) { cpu.RTI(); });
+    case 0x41: return visit([](Cpu& cpu) { cpu.EOR<IndirectX>(); });
+    case 0x45: return visit([](Cpu& cpu) { cpu.EOR<ZeroPage>(); });
+    case 0x46: return visit([](Cpu& cpu) { cpu.LSR<ZeroPage>(); });
+    case 0x48: return visit([](Cpu& cpu) { cpu.PHA(); });
+    case 0x49: return visit([](Cpu& cpu) { cpu.EOR<Immediate>(); });
+    case 0x4A: return visit([](Cpu& cpu) { cpu.LSR<Accumulator>(); });
+    case 0x4C: return visit([](Cpu& cpu) { cpu.JMP<Absolute>(); });
+    case 0x4D: return visit([](Cpu& cpu) { cpu.EOR<Absolute>(); });
+    case 0x4E: return visit([](Cpu& cpu) { cpu.LSR<Absolute>(); });
+    case 0x50: return visit([](Cpu& cpu) { cpu.BVC(); });
+    case 0x51: return visit([](Cpu& cpu) { cpu.EOR<IndirectY>(); });
+    case 0x55: return visit([](Cpu& cpu) { cpu.EOR<ZeroPageX>(); });
+    case 0x56: return visit([](Cpu& cpu) { cpu.LSR<ZeroPageX>(); });
+    case 0x58: return visit([](Cpu& cpu) { cpu.CLI(); });
+    case 0x59: return visit([](Cpu& cpu) { cpu.EOR<AbsoluteY>(); });
+    case 0x5D: return visit([](Cpu& cpu) { cpu.EOR<AbsoluteX>(); });
+    case 0x5E: return visit([](Cpu& cpu) { cpu.LSR<AbsoluteX_Exception>(); });
+    case 0x60: return visit([](Cpu& cpu) { cpu.RTS(); });
+    case 0x61: return visit([](Cpu& cpu) { cpu.ADC<IndirectX>(); });
+    case 0x65: return visit([](Cpu& cpu) { cpu.ADC<ZeroPage>(); });
+    case 0x66: return visit([](Cpu& cpu) { cpu.ROR<ZeroPage>(); });
+    case 0x68: return visit([](Cpu& cpu) { cpu.PLA(); });
+    case 0x69: return visit([](Cpu& cpu) { cpu.ADC<Immediate>(); });
+    case 0x6A: return visit([](Cpu& cpu) { cpu.ROR<Accumulator>(); });
+    case 0x6C: return visit([](Cpu& cpu) { cpu.JMP<Indirect>(); });
+    case 0x6D: return visit([](Cpu& cpu) { cpu.ADC<Absolute>(); });
+    case 0x6E: return visit([](Cpu& cpu) { cpu.ROR<Absolute>(); });
+    case 0x70: return visit([](Cpu& cpu) { cpu.BVS(); });
+    case 0x71: return visit([](Cpu& cpu) { cpu.ADC<IndirectY>(); });
+    case 0x75: return visit([](Cpu& cpu) { cpu.ADC<ZeroPageX>(); });
+    case 0x76: return visit([](Cpu& cpu) { cpu.ROR<ZeroPageX>(); });
+    case 0x78: return visit([](Cpu& cpu) { cpu.SEI(); });
+    case 0x79: return visit([](Cpu& cpu) { cpu.ADC<AbsoluteY>(); });
+    case 0x7D: return visit([](Cpu& cpu) { cpu.ADC<AbsoluteX>(); });
+    case 0x7E: return visit([](Cpu& cpu) { cpu.ROR<AbsoluteX_Exception>(); });
+    case 0x81: return visit([](Cpu& cpu) { cpu.STA<IndirectX>(); });
+    case 0x84: return visit([](Cpu& cpu) { cpu.STY<ZeroPage>(); });
+    case 0x85: return visit([](Cpu& cpu) { cpu.STA<ZeroPage>(); });
+    case 0x86: return visit([](Cpu& cpu) { cpu.STX<ZeroPage>(); });
+    case 0x88: return visit([](Cpu& cpu) { cpu.DEY(); });
+    case 0x8A: return visit([](Cpu& cpu) { cpu.TXA(); });
+    case 0x8C: return visit([](Cpu& cpu) { cpu.STY<Absolute>(); });
+    case 0x8D: return visit([](Cpu& cpu) { cpu.STA<Absolute>(); });
+    case 0x8E: return visit([](Cpu& cpu) { cpu.STX<Absolute>(); });
+    case 0x90: return visit([](Cpu& cpu) { cpu.BCC(); });
+    case 0x91: return visit([](Cpu& cpu) { cpu.STA<IndirectY_Exception>(); });
+    case 0x94: return visit([](Cpu& cpu) { cpu.STY<ZeroPageX>(); });
+    case 0x95: return visit([](Cpu& cpu) { cpu.STA<ZeroPageX>(); });
+    case 0x96: return visit([](Cpu& cpu) { cpu.STX<ZeroPageY>(); });
+    case 0x98: return visit([](Cpu& cpu) { cpu.TYA(); });
+    case 0x99: return visit([](Cpu& cpu) { cpu.STA<AbsoluteY_Exception>(); });
+    case 0x9A: return visit([](Cpu& cpu) { cpu.TXS(); });
+    case 0x9D: return visit([](Cpu& cpu) { cpu.STA<AbsoluteX_Exception>(); });
+    case 0xA0: return visit([](Cpu& cpu) { cpu.LDY<Immediate>(); });
+    case 0xA1: return visit([](Cpu& cpu) { cpu.LDA<IndirectX>(); });
+    case 0xA2: return visit([](Cpu& cpu) { cpu.LDX<Immediate>(); });
+    case 0xA4: return visit([](Cpu& cpu) { cpu.LDY<ZeroPage>(); });
+    case 0xA5: return visit([](Cpu& cpu) { cpu.LDA<ZeroPage>(); });
+    case 0xA6: return visit([](Cpu& cpu) { cpu.LDX<ZeroPage>(); });
+    case 0xA8: return visit([](Cpu& cpu) { cpu.TAY(); });
+    case 0xA9: return visit([](Cpu& cpu) { cpu.LDA<Immediate>(); });
+    case 0xAA: return visit([](Cpu& cpu) { cpu.TAX(); });
+    case 0xAC: return visit([](Cpu& cpu) { cpu.LDY<Absolute>(); });
+    case 0xAD: return visit([](Cpu& cpu) { cpu.LDA<Absolute>(); });
+    case 0xAE: return visit([](Cpu& cpu) { cpu.LDX<Absolute>(); });
+    case 0xB0: return visit([](Cpu& cpu) { cpu.BCS(); });
+    case 0xB1: return visit([](Cpu& cpu) { cpu.LDA<IndirectY>(); });
+    case 0xB4: return visit([](Cpu& cpu) { cpu.LDY<ZeroPageX>(); });
+    case 0xB5: return visit([](Cpu& cpu) { cpu.LDA<ZeroPageX>(); });
+    case 0xB6: return visit([](Cpu& cpu) { cpu.LDX<ZeroPageY>(); });
+    case 0xB8: return visit([](Cpu& cpu) { cpu.CLV(); });
+    case 0xB9: return visit([](Cpu& cpu) { cpu.LDA<AbsoluteY>(); });
+    case 0xBA: return visit([](Cpu& cpu) { cpu.TSX(); });
+    case 0xBC: return visit([](Cpu& cpu) { cpu.LDY<AbsoluteX>(); });
+    case 0xBD: return visit([](Cpu& cpu) { cpu.LDA<AbsoluteX>(); });
+    case 0xBE: return visit([](Cpu& cpu) { cpu.LDX<AbsoluteY>(); });
+    case 0xC0: return visit([](Cpu& cpu) { cpu.CPY<Immediate>(); });
+    case 0xC1: return visit([](Cpu& cpu) { cpu.CMP<IndirectX>(); });
+    case 0xC4: return visit([](Cpu& cpu) { cpu.CPY<ZeroPage>(); });
+    case 0xC5: return visit([](Cpu& cpu) { cpu.CMP<ZeroPage>(); });
+    case 0xC6: return visit([](Cpu& cpu) { cpu.DEC<ZeroPage>(); });
+    case 0xC8: return visit([](Cpu& cpu) { cpu.INY(); });
+    case 0xC9: return visit([](Cpu& cpu) { cpu.CMP<Immediate>(); });
+    case 0xCA: return visit([](Cpu& cpu) { cpu.DEX(); });
+    case 0xCC: return visit([](Cpu& cpu) { cpu.CPY<Absolute>(); });
+    case 0xCD: return visit([](Cpu& cpu) { cpu.CMP<Absolute>(); });
+    case 0xCE: return visit([](Cpu& cpu) { cpu.DEC<Absolute>(); });
+    case 0xD0: return visit([](Cpu& cpu) { cpu.BNE(); });
+    case 0xD1: return visit([](Cpu& cpu) { cpu.CMP<IndirectY>(); });
+    case 0xD5: return visit([](Cpu& cpu) { cpu.CMP<ZeroPageX>(); });
+    case 0xD6: return visit([](Cpu& cpu) { cpu.DEC<ZeroPageX>(); });
+    case 0xD8: return visit([](Cpu& cpu) { cpu.CLD(); });
+    case 0xD9: return visit([](Cpu& cpu) { cpu.CMP<AbsoluteY>(); });
+    case 0xDD: return visit([](Cpu& cpu) { cpu.CMP<AbsoluteX>(); });
+    case 0xDE: return visit([](Cpu& cpu) { cpu.DEC<AbsoluteX_Exception>(); });
+    case 0xE0: return visit([](Cpu& cpu) { cpu.CPX<Immediate>(); });
+    case 0xE1: return visit([](Cpu& cpu) { cpu.SBC<IndirectX>(); });
+    case 0xE4: return visit([](Cpu& cpu) { cpu.CPX<ZeroPage>(); });
+    case 0xE5: return visit([](Cpu& cpu) { cpu.SBC<ZeroPage>(); });
+    case 0xE6: return visit([](Cpu& cpu) { cpu.INC<ZeroPage>(); });
+    case 0xE8: return visit([](Cpu& cpu) { cpu.INX(); });
+    case 0xE9: return visit([](Cpu& cpu) { cpu.SBC<Immediate>(); });
+    case 0xEA: return visit([](Cpu& cpu) { cpu.NOP(); });
+    case 0xEC: return visit([](Cpu& cpu) { cpu.CPX<Absolute>(); });
+    case 0xED: return visit([](Cpu& cpu) { cpu.SBC<Absolute>(); });
+    case 0xEE: return visit([](Cpu& cpu) { cpu.INC<Absolute>(); });
+    case 0xF0: return visit([](Cpu& cpu) { cpu.BEQ(); });
+    case 0xF1: return visit([](Cpu& cpu) { cpu.SBC<IndirectY>(); });
+    case 0xF5: return visit([](Cpu& cpu) { cpu.SBC<ZeroPageX>(); });
+    case 0xF6: return visit([](Cpu& cpu) { cpu.INC<ZeroPageX>(); });
+    case 0xF8: return visit([](Cpu& cpu) { cpu.SED(); });
+    case 0xF9: return visit([](Cpu& cpu) { cpu.SBC<AbsoluteY>(); });
+    case 0xFD: return visit([](Cpu& cpu) { cpu.SBC<AbsoluteX>(); });
+    case 0xFE: return visit([](Cpu& cpu) { cpu.INC<AbsoluteX_Exception>(); });
+
+    //
+    // Unofficial instructions
+    //
+
+    // NOP
+    case 0x04:
+    case 0x44:
+    case 0x64: return visit([](Cpu& cpu) { cpu.NOP<ZeroPage>(); });
+    case 0x0C: return visit([](Cpu& cpu) { cpu.NOP<Absolute>(); });
+    case 0x14:
+    case 0x34:
+    case 0x54:
+    case 0x74:
+    case 0xD4:
+    case 0xF4: return visit([](Cpu& cpu) { cpu.NOP<ZeroPageX>(); });
+    case 0x1A:
+    case 0x3A:
+    case 0x5A:
+    case 0x7A:
+    case 0xDA:
+    case 0xFA: return visit([](Cpu& cpu) { cpu.NOP(); });
+    case 0x80:
+    case 0x82:
+    case 0x89:
+    case 0xC2:
+    case 0xE2: return visit([](Cpu& cpu) { cpu.NOP<Immediate>(); });
+    case 0x1C:
+    case 0x3C:
+    case 0x5C:
+    case 0x7C:
+    case 0xDC:
+    case 0xFC: return visit([](Cpu& cpu) { cpu.NOP<AbsoluteX>(); });
+
+    // LAX
+    case 0xA3: return visit([](Cpu& cpu) { cpu.LAX<IndirectX>(); });
+    case 0xA7: return visit([](Cpu& cpu) { cpu.LAX<ZeroPage>(); });
+    case 0xAF: return visit([](Cpu& cpu) { cpu.LAX<Absolute>(); });
+    case 0xB3: return visit([](Cpu& cpu) { cpu.LAX<IndirectY>(); });
+    case 0xB7: return visit([](Cpu& cpu) { cpu.LAX<ZeroPageY>(); });
+    case 0xBF: return visit([](Cpu& cpu) { cpu.LAX<AbsoluteY>(); });
+
+    // SAX
+    case 0x83: return visit([](Cpu& cpu) { cpu.SAX<IndirectX>(); });
+    case 0x87: return visit([](Cpu& cpu) { cpu.SAX<ZeroPage>(); });
+    case 0x8F: return visit([](Cpu& cpu) { cpu.SAX<Absolute>(); });
+    case 0x97: return visit([](Cpu& cpu) { cpu.SAX<ZeroPageY>(); });
+
+    // SBC
+    case 0xEB: return visit([](Cpu& cpu) { cpu.SBC<Immediate>(); });
+
+    // DCP
+    case 0xC3: return visit([](Cpu& cpu) { cpu.DCP<IndirectX>(); });
+    case 0xC7: return visit([](Cpu& cpu) { cpu.DCP<ZeroPage>(); });
+    case 0xCF: return visit([](Cpu& cpu) { cpu.DCP<Absolute>(); });
+    case 0xD3: return visit([](Cpu& cpu) { cpu.DCP<IndirectY>(); });
+    case 0xD7: return visit([](Cpu& cpu) { cpu.DCP<ZeroPageX>(); });
+    case 0xDB: return visit([](Cpu& cpu) { cpu.DCP<AbsoluteY>(); });
+    case 0xDF: return visit([](Cpu& cpu) { cpu.DCP<AbsoluteX>(); });
+
+    // ISB
+    case 0xE3: return visit([](Cpu& cpu) { cpu.ISB<IndirectX>(); });
+    case 0xE7: return visit([](Cpu& cpu) { cpu.ISB<ZeroPage>(); });
+    case 0xEF: return visit([](Cpu& cpu) { cpu.ISB<Absolute>(); });
+    case 0xF3: return visit([](Cpu& cpu) { cpu.ISB<IndirectY>(); });
+    case 0xF7: return visit([](Cpu& cpu) { cpu.ISB<ZeroPageX>(); });
+    case 0xFB: return visit([](Cpu& cpu) { cpu.ISB<AbsoluteY>(); });
+    case 0xFF: return visit([](Cpu& cpu) { cpu.ISB<AbsoluteX>(); });
+
+    // SLO
+    case 0x03: return visit([](Cpu& cpu) { cpu.SLO<IndirectX>(); });
+    case 0x07: return visit([](Cpu& cpu) { cpu.SLO<ZeroPage>(); });
+    case 0x0F: return visit([](Cpu& cpu) { cpu.SLO<Absolute>(); });
+    case 0x13: return visit([](Cpu& cpu) { cpu.SLO<IndirectY>(); });
+    case 0x17: return visit([](Cpu& cpu) { cpu.SLO<ZeroPageX>(); });
+    case 0x1B: return visit([](Cpu& cpu) { cpu.SLO<AbsoluteY>(); });
+    case 0x1F: return visit([](Cpu& cpu) { cpu.SLO<AbsoluteX>(); });
+
+    // RLA
+    case 0x23: return visit([](Cpu& cpu) { cpu.RLA<IndirectX>(); });
+    case 0x27: return visit([](Cpu& cpu) { cpu.RLA<ZeroPage>(); });
+    case 0x2F: return visit([](Cpu& cpu) { cpu.RLA<Absolute>(); });
+    case 0x33: return visit([](Cpu& cpu) { cpu.RLA<IndirectY>(); });
+    case 0x37: return visit([](Cpu& cpu) { cpu.RLA<ZeroPageX>(); });
+    case 0x3B: return visit([](Cpu& cpu) { cpu.RLA<AbsoluteY>(); });
+    case 0x3F: return visit([](Cpu& cpu) { cpu.RLA<AbsoluteX>(); });
+
+    // SRE
+    case 0x43: return visit([](Cpu& cpu) { cpu.SRE<IndirectX>(); });
+    case 0x47: return visit([](Cpu& cpu) { cpu.SRE<ZeroPage>(); });
+    case 0x4F: return visit([](Cpu& cpu) { cpu.SRE<Absolute>(); });
+    case 0x53: return visit([](Cpu& cpu) { cpu.SRE<IndirectY>(); });
+    case 0x57: return visit([](Cpu& cpu) { cpu.SRE<ZeroPageX>(); });
+    case 0x5B: return visit([](Cpu& cpu) { cpu.SRE<AbsoluteY>(); });
+    case 0x5F: return visit([](Cpu& cpu) { cpu.SRE<AbsoluteX>(); });
+
+    // RRA
+    case 0x63: return visit([](Cpu& cpu) { cpu.RRA<IndirectX>(); });
+    case 0x67: return visit([](Cpu& cpu) { cpu.RRA<ZeroPage>(); });
+    case 0x6F: return visit([](Cpu& cpu) { cpu.RRA<Absolute>(); });
+    case 0x73: return visit([](Cpu& cpu) { cpu.RRA<IndirectY>(); });
+    case 0x77: return visit([](Cpu& cpu) { cpu.RRA<ZeroPageX>(); });
+    case 0x7B: return visit([](Cpu& cpu) { cpu.RRA<AbsoluteY>(); });
+    case 0x7F: return visit([](Cpu& cpu) { cpu.RRA<AbsoluteX>(); });
+
+    // AAC
+    case 0x0B:
+    case 0x2B: return visit([](Cpu& cpu) { cpu.AAC<Immediate>(); });
+
+    // ASR
+    case 0x4B: return visit([](Cpu& cpu) { cpu.ASR<Immediate>(); });
+
+    // ARR
+    case 0x6B: return visit([](Cpu& cpu) { cpu.ARR<Immediate>(); });
+
+    // ATX
+    case 0xAB: return visit([](Cpu& cpu) { cpu.ATX<Immediate>(); });
+
+    // AXS
+    case 0xCB: return visit([](Cpu& cpu) { cpu.AXS<Immediate>(); });
+
+    // SYA
+    case 0x9C: return visit([](Cpu& cpu) { cpu.SYA<AbsoluteX_Exception>(); });
+
+    // SXA
+    case 0x9E: return visit([](Cpu& cpu) { cpu.SXA<AbsoluteY_Exception>(); });
+
+    default: return visit([](Cpu& cpu) { cpu.invalid_opcode(); });
+  }
+}
+
+auto Cpu::get_handler(const u8 opcode) -> Handler {
+  static constexpr auto table = [] {
+    std::array<Handler, 0x100> handlers = {};
+
+    for (usize i = 0; i < handlers.size(); ++i) {
+      handlers[i] = decode(static_cast<u8>(i), [](auto instruction) -> Handler {
+        return instruction;
+      });
+    }
+
+    return handlers;
+  }();
+
+  return table[opcode];
+}
+
+template <auto Dispatch>
+void Cpu::execute() {
+  const u8 opcode = memory_read(get_operand<Immediate>());
+
+  if constexpr (Dispatch == types::cpu::Dispatch::Table) {
+    get_handler(opcode)(*this);
+  } else {
+    decode(opcode, [this](auto instruction) { instruction(*this); });
+  }
+}
+
+void Cpu::invalid_opcode() {
+  const auto opcode = peek(static_cast<u16>(state.pc - 1));
+
+  const auto error_message = std::format("Invalid opcode: 0x{:02X}", opcode);
+  spdlog::error(error_message);
+  throw std::runtime_error(error_message);
+}
+
+// Explicit instantiation
+template void Cpu::execute<types::cpu::Dispatch::Switch>();
+template void Cpu::execute<types::cpu::Dispatch::Table>();
 } // namespace nes
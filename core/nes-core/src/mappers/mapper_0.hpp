@@ -5,6 +5,6 @@
 namespace nes {
 class Mapper0 final: public BaseMapper {
 public:
-  void reset() override;
+  void reset();
 };
 } // namespace nes
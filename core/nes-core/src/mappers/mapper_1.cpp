@@ -2,6 +2,7 @@
 
 #include "../base_mapper.hpp"
 #include "lib/common.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
 void Mapper1::reset() {
@@ -82,4 +83,14 @@ void Mapper1::write(const u16 addr, const u8 value) {
     apply();
   }
 }
+
+void Mapper1::save(utility::SnapshotWriter& out) const {
+  BaseMapper::save(out);
+  dump_snapshot(out, write_delay, shift_reg, control, chr_bank_0, chr_bank_1, prg_bank);
+}
+
+void Mapper1::load(utility::SnapshotReader& in) {
+  BaseMapper::load(in);
+  get_snapshot(in, write_delay, shift_reg, control, chr_bank_0, chr_bank_1, prg_bank);
+}
 } // namespace nes
@@ -5,9 +5,12 @@
 namespace nes {
 class Mapper1 final: public BaseMapper {
 public:
-  void reset() override;
+  void reset();
 
-  void write(u16 addr, u8 value) override;
+  void write(u16 addr, u8 value);
+
+  void save(utility::SnapshotWriter& out) const override;
+  void load(utility::SnapshotReader& in) override;
 
 private:
   void apply();
@@ -3,6 +3,7 @@
 #include <stdexcept>
 
 #include "lib/common.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
 void Mapper2::reset() {
@@ -23,4 +24,14 @@ void Mapper2::write(const u16 addr, const u8 value) {
   mode = value;
   apply();
 }
+
+void Mapper2::save(utility::SnapshotWriter& out) const {
+  BaseMapper::save(out);
+  dump_snapshot(out, mode);
+}
+
+void Mapper2::load(utility::SnapshotReader& in) {
+  BaseMapper::load(in);
+  get_snapshot(in, mode);
+}
 } // namespace nes
@@ -2,6 +2,7 @@
 
 #include "../base_mapper.hpp"
 #include "lib/common.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
 void Mapper4::reset() {
@@ -53,9 +54,16 @@ void Mapper4::write(const u16 addr, const u8 value) {
   if (addr < 0x8000) {
     // prg_ram[addr - 0x6000] = value;
   } else if ((addr & 0x8000) != 0) {
+    // Only the bank registers need the banks to be rebuilt
     switch (addr & 0xE001) {
-      case 0x8000: reg_8000 = value; break;
-      case 0x8001: regs[reg_8000 & 7] = value; break;
+      case 0x8000:
+        reg_8000 = value;
+        apply();
+        break;
+      case 0x8001:
+        regs[reg_8000 & 7] = value;
+        apply();
+        break;
       case 0xA000:
         set_mirroring((value & 1) != 0 ? MirroringType::Horizontal : MirroringType::Vertical);
         break;
@@ -71,20 +79,16 @@ void Mapper4::write(const u16 addr, const u8 value) {
         break; // TODO: handle this
       }
     }
-
-    apply();
   }
 }
 
-void Mapper4::increment_scanline_counter() {
-  if (irq_counter == 0) {
-    irq_counter = irq_period;
-  } else {
-    --irq_counter;
-  }
+void Mapper4::save(utility::SnapshotWriter& out) const {
+  BaseMapper::save(out);
+  dump_snapshot(out, regs, reg_8000, irq_enabled, irq_period, irq_counter);
+}
 
-  if (irq_enabled && irq_counter == 0) {
-    set_irq(true);
-  }
+void Mapper4::load(utility::SnapshotReader& in) {
+  BaseMapper::load(in);
+  get_snapshot(in, regs, reg_8000, irq_enabled, irq_period, irq_counter);
 }
 } // namespace nes
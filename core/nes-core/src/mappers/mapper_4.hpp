@@ -5,11 +5,29 @@
 namespace nes {
 class Mapper4 final: public BaseMapper {
 public:
-  void reset() override;
+  void reset();
 
-  void write(u16 addr, u8 value) override;
+  void write(u16 addr, u8 value);
 
-  void increment_scanline_counter() override;
+  void save(utility::SnapshotWriter& out) const override;
+  void load(utility::SnapshotReader& in) override;
+
+  // Called on every rendered scanline, defined here to be inlined into the PPU
+  void increment_scanline_counter() {
+    if (irq_counter == 0) {
+      irq_counter = irq_period;
+    } else {
+      --irq_counter;
+    }
+
+    if (irq_enabled && irq_counter == 0) {
+      set_irq(true);
+    }
+  }
+
+  [[nodiscard]] auto has_scanline_irq() const -> bool {
+    return irq_enabled;
+  }
 
 private:
   void apply();
@@ -4,6 +4,7 @@
 
 #include "../base_mapper.hpp"
 #include "lib/common.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
 void Mapper7::reset() {
@@ -27,4 +28,14 @@ void Mapper7::write(const u16 addr, const u8 value) {
   mode = value;
   apply();
 }
+
+void Mapper7::save(utility::SnapshotWriter& out) const {
+  BaseMapper::save(out);
+  dump_snapshot(out, mode);
+}
+
+void Mapper7::load(utility::SnapshotReader& in) {
+  BaseMapper::load(in);
+  get_snapshot(in, mode);
+}
 } // namespace nes
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <variant>
+
+#include "mapper_0.hpp"
+#include "mapper_1.hpp"
+#include "mapper_2.hpp"
+#include "mapper_4.hpp"
+#include "mapper_7.hpp"
+
+namespace nes {
+// Every supported mapper. A new one is added here and constructed in Cartridge::load(), the CPU
+// and the PPU only see the cartridge.
+using Mapper = std::variant<Mapper0, Mapper1, Mapper2, Mapper4, Mapper7>;
+} // namespace nes
@@ -0,0 +1,296 @@
+#include "nes/movie.hpp"
+
+#include <array>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "lib/common.hpp"
+#include "lib/hash.hpp"
+#include "nes/nes.hpp"
+#include "utility/snapshotable.hpp"
+
+namespace nes {
+namespace {
+  constexpr u32 MOVIE_MAGIC = 0x4D53'454E; // "NESM"
+  constexpr u32 MOVIE_VERSION = 1;
+
+  void apply_event(Nes& nes, const Movie::Event event) {
+    switch (event) {
+      case Movie::Event::None: break;
+      case Movie::Event::Reset: nes.reset(); break;
+      case Movie::Event::PowerOn: nes.power_on(); break;
+
+      default: unreachable();
+    }
+  }
+} // namespace
+
+//
+// Movie
+//
+
+auto Movie::get_hashes(const Nes& nes) -> Hashes {
+  auto frame = lib::Fnv1a();
+  frame.add(nes.get_frame_indices());
+  frame.add(nes.get_frame_emphasis());
+
+  return {.ram = lib::fnv1a(nes.get_cpu_ram()), .frame = frame.get()};
+}
+
+auto Movie::load(const std::filesystem::path& path) -> Movie {
+  auto file = std::ifstream(path, std::ios::binary);
+
+  if (!file) {
+    throw std::runtime_error(std::format("Can't open the movie {}", path.string()));
+  }
+
+  const auto data = std::vector<u8>(std::istreambuf_iterator<char>(file), {});
+
+  return deserialize(data);
+}
+
+void Movie::save(const std::filesystem::path& path) const {
+  auto file = std::ofstream(path, std::ios::binary);
+
+  if (!file) {
+    throw std::runtime_error(std::format("Can't create the movie {}", path.string()));
+  }
+
+  const auto data = serialize();
+  file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+auto Movie::deserialize(const std::span<const u8> data) -> Movie {
+  auto in = utility::SnapshotReader(data);
+  auto movie = Movie();
+
+  u32 magic = 0;
+  u32 version = 0;
+  in.read(magic);
+  in.read(version);
+
+  if (magic != MOVIE_MAGIC) {
+    throw std::runtime_error("Invalid movie: not a movie");
+  }
+
+  if (version != MOVIE_VERSION) {
+    throw std::runtime_error(
+      std::format("Invalid movie: version {} (expected {})", version, MOVIE_VERSION)
+    );
+  }
+
+  in.read(movie.rom_hash);
+  in.read(movie.start_state);
+
+  usize frame_count = 0;
+  usize run_count = 0;
+  in.read(frame_count);
+  in.read(run_count);
+
+  for (usize run = 0; run < run_count; ++run) {
+    u32 length = 0;
+    auto input = Input();
+    in.read(length);
+    in.read(input);
+
+    if (input.event > Event::PowerOn) {
+      throw std::runtime_error("Invalid movie: unknown event");
+    }
+
+    if (length > frame_count - movie.inputs.size()) {
+      throw std::runtime_error("Invalid movie: too many frames");
+    }
+
+    movie.inputs.insert(movie.inputs.end(), length, input);
+  }
+
+  in.read(movie.hashes);
+
+  if (movie.inputs.size() != frame_count) {
+    throw std::runtime_error("Invalid movie: missing frames");
+  }
+
+  if (!movie.hashes.empty() && movie.hashes.size() != frame_count) {
+    throw std::runtime_error("Invalid movie: missing hashes");
+  }
+
+  if (!in.is_done()) {
+    throw std::runtime_error("Invalid movie: trailing data");
+  }
+
+  return movie;
+}
+
+auto Movie::serialize() const -> std::vector<u8> {
+  // Runs of identical inputs, a frame with an event is a run of its own
+  auto runs = std::vector<std::pair<u32, Input>>();
+
+  for (const auto& input : inputs) {
+    const auto extends_run = !runs.empty() && input.event == Event::None &&
+                             runs.back().second.event == Event::None &&
+                             runs.back().second.state == input.state &&
+                             runs.back().first < std::numeric_limits<u32>::max();
+
+    if (extends_run) {
+      ++runs.back().first;
+    } else {
+      runs.emplace_back(1, input);
+    }
+  }
+
+  auto data = std::vector<u8>();
+  auto out = utility::SnapshotWriter(data);
+
+  out.write(MOVIE_MAGIC);
+  out.write(MOVIE_VERSION);
+  out.write(rom_hash);
+  out.write(start_state);
+  out.write(inputs.size());
+  out.write(runs.size());
+
+  for (const auto& [length, input] : runs) {
+    out.write(length);
+    out.write(input);
+  }
+
+  out.write(hashes);
+
+  return data;
+}
+
+auto Movie::get_rom_hash() const -> u64 {
+  return rom_hash;
+}
+
+auto Movie::get_start_state() const -> std::span<const u8> {
+  return start_state;
+}
+
+auto Movie::size() const -> usize {
+  return inputs.size();
+}
+
+auto Movie::get_input(const usize frame) const -> Input {
+  return inputs.at(frame);
+}
+
+auto Movie::has_hashes() const -> bool {
+  return !hashes.empty();
+}
+
+auto Movie::get_hashes(const usize frame) const -> Hashes {
+  return hashes.at(frame);
+}
+
+//
+// MovieRecorder
+//
+
+MovieRecorder::MovieRecorder(Nes& nes, const Start start, const bool with_hashes) :
+  record_hashes(with_hashes) {
+  if (start == Start::PowerOn) {
+    nes.power_on();
+  } else {
+    nes.save_state(movie.start_state);
+  }
+
+  movie.rom_hash = nes.get_rom_hash();
+}
+
+void MovieRecorder::reset(Nes& nes) {
+  add_event(Movie::Event::Reset);
+  nes.reset();
+}
+
+void MovieRecorder::power_on(Nes& nes) {
+  add_event(Movie::Event::PowerOn);
+  nes.power_on();
+}
+
+void MovieRecorder::add_event(const Movie::Event event) {
+  if (pending_event != Movie::Event::None) {
+    throw std::logic_error("A movie records at most one reset or power on per frame");
+  }
+
+  pending_event = event;
+}
+
+void MovieRecorder::run_frame(Nes& nes, const std::array<u8, 2> state) {
+  nes.update_controller_state(0, state[0]);
+  nes.update_controller_state(1, state[1]);
+  nes.run_frame();
+
+  movie.inputs.push_back({.state = state, .event = std::exchange(pending_event, {})});
+
+  if (record_hashes) {
+    movie.hashes.push_back(Movie::get_hashes(nes));
+  }
+}
+
+auto MovieRecorder::get_movie() const -> const Movie& {
+  return movie;
+}
+
+//
+// MoviePlayer
+//
+
+MoviePlayer::MoviePlayer(Movie movie_value, Nes& nes) : movie(std::move(movie_value)) {
+  nes.power_on();
+
+  if (nes.get_rom_hash() != movie.get_rom_hash()) {
+    throw std::runtime_error("The movie was recorded with another ROM");
+  }
+
+  if (!movie.get_start_state().empty()) {
+    nes.load_state(movie.get_start_state());
+  }
+}
+
+auto MoviePlayer::is_done() const -> bool {
+  return frame == movie.size();
+}
+
+auto MoviePlayer::get_frame() const -> usize {
+  return frame;
+}
+
+auto MoviePlayer::get_movie() const -> const Movie& {
+  return movie;
+}
+
+void MoviePlayer::run_frame(Nes& nes) {
+  if (is_done()) {
+    return;
+  }
+
+  const auto input = movie.get_input(frame);
+
+  apply_event(nes, input.event);
+  nes.update_controller_state(0, input.state[0]);
+  nes.update_controller_state(1, input.state[1]);
+  nes.run_frame();
+
+  if (movie.has_hashes()) {
+    const auto expected = movie.get_hashes(frame);
+    const auto actual = Movie::get_hashes(nes);
+
+    if (actual.ram != expected.ram) {
+      throw std::runtime_error(std::format("Movie desync at frame {}: CPU RAM differs", frame));
+    }
+
+    if (actual.frame != expected.frame) {
+      throw std::runtime_error(std::format("Movie desync at frame {}: picture differs", frame));
+    }
+  }
+
+  ++frame;
+}
+} // namespace nes
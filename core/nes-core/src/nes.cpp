@@ -1,66 +1,197 @@
 #include "nes/nes.hpp"
 
 #include <filesystem>
+#include <format>
 #include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
 
+#include "apu.hpp"
 #include "cartridge.hpp"
 #include "controller.hpp"
 #include "cpu.hpp"
 #include "lib/common.hpp"
+#include "lib/hash.hpp"
 #include "ppu.hpp"
 #include "utility/file_manager.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
+namespace {
+  constexpr u32 SNAPSHOT_MAGIC = 0x5353'454E; // "NESS"
+  constexpr u32 SNAPSHOT_VERSION = 4;         // Bump on any change to a component's layout
+
+  void read_header(utility::SnapshotReader& in) {
+    u32 magic = 0;
+    u32 version = 0;
+    in.read(magic);
+    in.read(version);
+
+    if (magic != SNAPSHOT_MAGIC) {
+      throw std::runtime_error("Invalid snapshot: not a savestate");
+    }
+
+    if (version != SNAPSHOT_VERSION) {
+      throw std::runtime_error(
+        std::format("Invalid snapshot: version {} (expected {})", version, SNAPSHOT_VERSION)
+      );
+    }
+  }
+} // namespace
+
+Nes::Nes() :
+  file_manager(std::make_unique<utility::FileManager>()),
+  cartridge(std::make_unique<Cartridge>()),
+  controller(std::make_unique<Controller>()),
+  ppu(std::make_unique<Ppu>(*cartridge)),
+  apu(std::make_unique<Apu>(*cartridge)),
+  cpu(std::make_unique<Cpu>(*ppu, *apu, *cartridge, *controller)) {}
+
+Nes::~Nes() = default;
+
+Nes::Nes(Nes&&) noexcept = default;
+auto Nes::operator=(Nes&&) noexcept -> Nes& = default;
+
 void Nes::set_app_path(const std::filesystem::path& path) {
-  utility::FileManager::get().set_app_path(path);
+  file_manager->set_app_path(path);
 }
 
 void Nes::load(const std::filesystem::path& path) {
-  utility::FileManager::get().set_rom(path);
+  file_manager->set_rom(path);
 }
 
 void Nes::reset() {
-  Cpu::get().reset();
-  Ppu::get().reset();
+  cpu->reset();
+  ppu->reset();
+  apu->reset();
 }
 
 void Nes::power_on() {
   const auto irq = std::make_shared<bool>(false);
-  Cpu::get().irq = irq;
+  cpu->irq = irq;
 
   const auto nmi = std::make_shared<bool>(false);
-  Cpu::get().nmi = nmi;
-  Ppu::get().nmi = nmi;
+  cpu->nmi = nmi;
+  ppu->nmi = nmi;
 
   auto prg_ram = std::optional<std::vector<u8>>();
 
-  if (utility::FileManager::get().has_prg_ram()) {
-    prg_ram = utility::FileManager::get().get_prg_ram();
+  if (file_manager->has_prg_ram()) {
+    prg_ram = file_manager->get_prg_ram();
   }
 
-  Cartridge::get().load(utility::FileManager::get().get_rom(), prg_ram, irq);
+  cartridge->load(file_manager->get_rom(), prg_ram, irq);
 
-  const auto palette = utility::FileManager::get().get_palette();
-  Ppu::get().set_palette(palette);
+  const auto palette = file_manager->get_palette();
+  ppu->set_palette(palette);
 
-  Cpu::get().power_on();
-  Ppu::get().power_on();
+  cpu->power_on();
+  ppu->power_on();
+  apu->power_on();
 }
 
 void Nes::power_off() {
-  const auto prg_ram = Cartridge::get().get_prg_ram();
-  utility::FileManager::get().save_prg_ram(prg_ram);
+  const auto prg_ram = cartridge->get_prg_ram();
+  file_manager->save_prg_ram(prg_ram);
 }
 
 void Nes::run_frame() {
-  Cpu::get().run_frame();
+  cpu->run_frame();
 }
 
 auto Nes::get_frame_buffer() -> const u32* {
-  return Ppu::get().get_frame_buffer();
+  return ppu->get_frame_buffer();
+}
+
+auto Nes::get_frame_indices() const -> std::span<const u8> {
+  return ppu->get_frame_indices();
+}
+
+auto Nes::get_frame_emphasis() const -> u8 {
+  return ppu->get_frame_emphasis();
 }
 
 void Nes::update_controller_state(const usize port, const u8 state) {
-  Controller::get().update_state(port, state);
+  controller->update_state(port, state);
+}
+
+auto Nes::get_cpu_ram() const -> std::span<const u8> {
+  return cpu->get_ram();
+}
+
+auto Nes::get_rom_hash() const -> u64 {
+  return lib::fnv1a(cartridge->get_rom());
+}
+
+void Nes::set_output_enabled(const bool enabled) {
+  ppu->set_output_enabled(enabled);
+}
+
+auto Nes::needs_output(const usize frames_left) -> bool {
+  return frames_left < 2;
+}
+
+void Nes::set_audio_enabled(const bool enabled) {
+  apu->set_output_enabled(enabled);
+}
+
+auto Nes::is_audio_enabled() const -> bool {
+  return apu->get_output_enabled();
+}
+
+auto Nes::read_audio_samples(const std::span<float> samples) -> usize {
+  return apu->read_samples(samples);
+}
+
+void Nes::save_state(std::vector<u8>& state) const {
+  state.clear();
+
+  utility::SnapshotWriter out(state);
+  out.write(SNAPSHOT_MAGIC);
+  out.write(SNAPSHOT_VERSION);
+
+  cartridge->save(out);
+  controller->save(out);
+  ppu->save(out);
+  apu->save(out);
+  cpu->save(out);
+}
+
+auto Nes::save_state() const -> std::vector<u8> {
+  std::vector<u8> state;
+  save_state(state);
+  return state;
+}
+
+void Nes::load_state(const std::span<const u8> state) {
+  utility::SnapshotReader in(state);
+  read_header(in);
+
+  // The components are restored one after another, and their pages point into each other:
+  // if one of them rejects its data, the whole console goes back to where it was
+  save_state(load_backup);
+
+  try {
+    load_components(in);
+
+    if (!in.is_done()) {
+      throw std::runtime_error("Invalid snapshot: trailing data");
+    }
+  } catch (...) {
+    utility::SnapshotReader backup(load_backup);
+    read_header(backup);
+    load_components(backup);
+    throw;
+  }
+}
+
+void Nes::load_components(utility::SnapshotReader& in) {
+  cartridge->load(in);
+  controller->load(in);
+  ppu->load(in);
+  apu->load(in);
+  cpu->load(in);
 }
 } // namespace nes
@@ -0,0 +1,88 @@
+#include "nes/nes_batch.hpp"
+
+#include <algorithm>
+#include <format>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <thread>
+
+#include "lib/common.hpp"
+#include "nes/constants.hpp"
+#include "nes/nes.hpp"
+#include "utility/thread_pool.hpp"
+
+namespace nes {
+namespace {
+  constexpr usize FRAME_PIXELS = usize{SCREEN_WIDTH} * SCREEN_HEIGHT;
+
+  auto default_thread_count() -> usize {
+    return std::max(usize{std::thread::hardware_concurrency()}, usize{1});
+  }
+} // namespace
+
+NesBatch::NesBatch(const usize size, const usize thread_count) :
+  nes_list(size),
+  thread_pool(std::make_unique<utility::ThreadPool>(
+    thread_count == 0 ? default_thread_count() : thread_count
+  )) {}
+
+NesBatch::~NesBatch() = default;
+
+NesBatch::NesBatch(NesBatch&&) noexcept = default;
+auto NesBatch::operator=(NesBatch&&) noexcept -> NesBatch& = default;
+
+auto NesBatch::size() const -> usize {
+  return nes_list.size();
+}
+
+auto NesBatch::thread_count() const -> usize {
+  return thread_pool->thread_count();
+}
+
+auto NesBatch::get(const usize index) -> Nes& {
+  return nes_list.at(index);
+}
+
+auto NesBatch::consoles() -> std::span<Nes> {
+  return nes_list;
+}
+
+void NesBatch::run_frame() {
+  thread_pool->for_each(nes_list.size(), [this](const usize index) {
+    nes_list[index].run_frame();
+  });
+}
+
+void NesBatch::run_frame(std::span<u32> frames) {
+  check_frames_size(frames.size());
+
+  thread_pool->for_each(nes_list.size(), [this, frames](const usize index) {
+    auto& nes = nes_list[index];
+    nes.run_frame();
+
+    const auto destination = frames.subspan(index * FRAME_PIXELS, FRAME_PIXELS);
+    std::copy_n(nes.get_frame_buffer(), FRAME_PIXELS, destination.begin());
+  });
+}
+
+void NesBatch::run_frame(std::span<u8> frames) {
+  check_frames_size(frames.size());
+
+  thread_pool->for_each(nes_list.size(), [this, frames](const usize index) {
+    auto& nes = nes_list[index];
+    nes.run_frame();
+
+    const auto destination = frames.subspan(index * FRAME_PIXELS, FRAME_PIXELS);
+    std::ranges::copy(nes.get_frame_indices(), destination.begin());
+  });
+}
+
+void NesBatch::check_frames_size(const usize size) const {
+  if (size < nes_list.size() * FRAME_PIXELS) {
+    throw std::invalid_argument(
+      std::format("Frame buffer too small: {} < {}", size, nes_list.size() * FRAME_PIXELS)
+    );
+  }
+}
+} // namespace nes
@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "lib/common.hpp"
+#include "nes/netplay.hpp"
+
+namespace nes::netplay {
+struct LoopbackTransport::Queue {
+  struct Entry {
+    std::chrono::steady_clock::time_point arrival;
+    InputPacket packet;
+  };
+
+  std::mutex mutex;
+  std::vector<Entry> entries;
+};
+
+auto LoopbackTransport::make_pair(const Settings& settings)
+  -> std::pair<LoopbackTransport, LoopbackTransport> {
+  const auto a_to_b = std::make_shared<Queue>();
+  const auto b_to_a = std::make_shared<Queue>();
+
+  return {
+    LoopbackTransport(b_to_a, a_to_b, settings, settings.seed),
+    LoopbackTransport(a_to_b, b_to_a, settings, settings.seed + 1),
+  };
+}
+
+LoopbackTransport::LoopbackTransport(
+  std::shared_ptr<Queue> inbox_ptr,
+  std::shared_ptr<Queue> outbox_ptr,
+  const Settings& settings_ref,
+  const u32 seed
+) :
+  inbox(std::move(inbox_ptr)),
+  outbox(std::move(outbox_ptr)),
+  settings(settings_ref),
+  rng(seed) {}
+
+void LoopbackTransport::send(const InputPacket& packet) {
+  auto jitter =
+    std::uniform_int_distribution<std::chrono::microseconds::rep>(0, settings.jitter.count());
+  const auto latency = settings.delay + std::chrono::microseconds(jitter(rng));
+
+  const auto lock = std::scoped_lock(outbox->mutex);
+  outbox->entries.push_back({std::chrono::steady_clock::now() + latency, packet});
+}
+
+// With jitter, packets can overtake each other
+auto LoopbackTransport::receive() -> std::optional<InputPacket> {
+  const auto now = std::chrono::steady_clock::now();
+
+  const auto lock = std::scoped_lock(inbox->mutex);
+  auto& entries = inbox->entries;
+
+  const auto it = std::ranges::min_element(entries, {}, &Queue::Entry::arrival);
+
+  if (it == entries.end() || it->arrival > now) {
+    return std::nullopt;
+  }
+
+  const auto packet = it->packet;
+  entries.erase(it);
+
+  return packet;
+}
+} // namespace nes::netplay
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <stdexcept>
+
+#include "lib/common.hpp"
+#include "nes/nes.hpp"
+#include "nes/netplay.hpp"
+
+namespace nes::netplay {
+Session::Session(
+  Nes& nes_ref,
+  Transport& transport_ref,
+  const usize port,
+  const usize rollback_frames
+) :
+  nes(&nes_ref),
+  transport(&transport_ref),
+  local_port(port),
+  remote_port(1 - port),
+  max_rollback(rollback_frames),
+  history(rollback_frames + 1),
+  remote_inputs(2 * (rollback_frames + 1)) {
+  if (port > 1) {
+    throw std::invalid_argument(std::format("Invalid controller port: {}", port));
+  }
+
+  if (rollback_frames == 0) {
+    throw std::invalid_argument("Netplay needs at least one frame of rollback");
+  }
+}
+
+auto Session::advance_frame(const u8 local_input) -> bool {
+  poll();
+
+  // Every frame since the last confirmed one must stay in the history to roll back to it
+  if (frame > confirmed_frame + max_rollback) {
+    return false;
+  }
+
+  auto& data = get_frame_data(frame);
+  nes->save_state(data.state);
+  data.local_input = local_input;
+
+  transport->send({.frame = frame, .input = local_input});
+
+  run_frame(frame);
+  ++frame;
+
+  return true;
+}
+
+void Session::poll() {
+  while (const auto packet = transport->receive()) {
+    if (packet->frame < confirmed_frame) {
+      continue; // Duplicate
+    }
+
+    if (packet->frame >= confirmed_frame + remote_inputs.size()) {
+      throw std::runtime_error(
+        std::format("Netplay input for frame {} is too far ahead of frame {}", packet->frame, frame)
+      );
+    }
+
+    get_remote_input(packet->frame) = {
+      .frame = packet->frame,
+      .input = packet->input,
+      .is_valid = true,
+    };
+  }
+
+  // Inputs are confirmed in order, the first wrong prediction is where the rollback starts
+  auto mispredicted_frame = frame;
+
+  while (true) {
+    const auto& remote = get_remote_input(confirmed_frame);
+
+    if (!remote.is_valid || remote.frame != confirmed_frame) {
+      break;
+    }
+
+    if (confirmed_frame < frame && mispredicted_frame == frame &&
+        get_frame_data(confirmed_frame).remote_input != remote.input) {
+      mispredicted_frame = confirmed_frame;
+    }
+
+    ++confirmed_frame;
+  }
+
+  if (mispredicted_frame < frame) {
+    rollback(mispredicted_frame);
+  }
+}
+
+auto Session::get_frame() const -> u32 {
+  return frame;
+}
+
+auto Session::get_confirmed_frame() const -> u32 {
+  return confirmed_frame;
+}
+
+auto Session::get_stats() const -> const Stats& {
+  return stats;
+}
+
+auto Session::get_frame_data(const u32 frame_index) -> FrameData& {
+  return history[frame_index % history.size()];
+}
+
+auto Session::get_remote_input(const u32 frame_index) -> RemoteInput& {
+  return remote_inputs[frame_index % remote_inputs.size()];
+}
+
+// The last confirmed input is repeated until the next one arrives
+auto Session::predict_remote_input(const u32 frame_index) -> u8 {
+  if (frame_index < confirmed_frame) {
+    return get_remote_input(frame_index).input;
+  }
+
+  return confirmed_frame == 0 ? u8{0} : get_remote_input(confirmed_frame - 1).input;
+}
+
+void Session::run_frame(const u32 frame_index) {
+  auto& data = get_frame_data(frame_index);
+  data.remote_input = predict_remote_input(frame_index);
+
+  nes->update_controller_state(local_port, data.local_input);
+  nes->update_controller_state(remote_port, data.remote_input);
+  nes->run_frame();
+}
+
+// Goes back to the start of `from_frame` and runs again up to the current frame. The frames that
+// aren't shown run without output; their audio has already been played, so none of them is heard.
+void Session::rollback(const u32 from_frame) {
+  const auto start = std::chrono::steady_clock::now();
+
+  nes->load_state(get_frame_data(from_frame).state);
+
+  const auto is_audio_enabled = nes->is_audio_enabled();
+  nes->set_audio_enabled(false);
+
+  for (auto i = from_frame; i < frame; ++i) {
+    if (i != from_frame) {
+      nes->save_state(get_frame_data(i).state);
+    }
+
+    nes->set_output_enabled(Nes::needs_output(frame - 1 - i));
+    run_frame(i);
+  }
+
+  nes->set_output_enabled(true);
+  nes->set_audio_enabled(is_audio_enabled);
+
+  const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - start
+  );
+
+  ++stats.rollbacks;
+  stats.resimulated_frames += frame - from_frame;
+  stats.max_rollback_time = std::max(stats.max_rollback_time, elapsed);
+}
+} // namespace nes::netplay
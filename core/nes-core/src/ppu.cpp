@@ -1,6 +1,9 @@
 #include "ppu.hpp"
 
 #include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <span>
 #include <stdexcept>
 
 #include <spdlog/spdlog.h>
@@ -8,12 +11,23 @@
 #include "cartridge.hpp"
 #include "lib/common.hpp"
 #include "types/ppu_types.hpp"
+#include "utility/palette_conversion.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
-auto Ppu::get() -> Ppu& {
-  static Ppu instance;
-  return instance;
-}
+namespace {
+#ifdef NES_PPU_SCANLINE_RENDERER
+  constexpr bool SCANLINE_RENDERER = true;
+#else
+  constexpr bool SCANLINE_RENDERER = false;
+#endif
+
+  // Sprite line buffer flags
+  constexpr u8 SPRITE_BEHIND = 0x40; // Behind the background
+  constexpr u8 SPRITE_ZERO = 0x80;
+} // namespace
+
+Ppu::Ppu(Cartridge& cartridge_ref) : cartridge(&cartridge_ref) {}
 
 void Ppu::power_on() {
   ctrl.raw = 0;
@@ -31,6 +45,8 @@ void Ppu::power_on() {
   ppudata_buffer = 0;
 
   is_odd_frame = false;
+
+  update_nametables();
 }
 
 void Ppu::reset() {
@@ -48,10 +64,24 @@ void Ppu::reset() {
   is_odd_frame = false;
 }
 
-auto Ppu::get_frame_buffer() const -> const u32* {
+auto Ppu::get_frame_buffer() -> const u32* {
+  if (is_frame_buffer_stale) {
+    const auto& frame = frames[ready_frame];
+    utility::convert_palette(frame.pixels, full_nes_palette[frame.emphasis], frame_buffer);
+    is_frame_buffer_stale = false;
+  }
+
   return frame_buffer.data();
 }
 
+auto Ppu::get_frame_indices() const -> std::span<const u8> {
+  return frames[ready_frame].pixels;
+}
+
+auto Ppu::get_frame_emphasis() const -> u8 {
+  return frames[ready_frame].emphasis;
+}
+
 void Ppu::set_palette(const std::vector<u8>& palette) {
   if (palette.size() != static_cast<usize>(64 * 3)) {
     throw std::invalid_argument("Invalid palette file");
@@ -105,6 +135,91 @@ void Ppu::set_palette(const std::vector<u8>& palette) {
       full_nes_palette[i][j] = color;
     }
   }
+
+  is_frame_buffer_stale = true;
+}
+
+void Ppu::set_output_enabled(const bool enabled) {
+  is_output_enabled = enabled;
+}
+
+void Ppu::save(utility::SnapshotWriter& out) const {
+  dump_snapshot(out, ppu_state, ppu_addr, bus_latch, ppudata_buffer, addr_latch);
+  dump_snapshot(out, ci_ram, cg_ram, oam_mem);
+
+  // Field by field, SpriteInfo has padding
+  for (const auto* sprites : {&oam, &sec_oam}) {
+    for (const auto& sprite : *sprites) {
+      dump_snapshot(out, sprite.y, sprite.tile, sprite.attr, sprite.x, sprite.id, sprite.data);
+    }
+  }
+
+  dump_snapshot(out, vram_addr, temp_addr, fine_x, oam_addr, ctrl, mask, status);
+  dump_snapshot(out, nt_latch, at_latch, bg_latch, at_shift, bg_shift, at_bits);
+  dump_snapshot(out, scanline, tick, is_odd_frame);
+  dump_snapshot(out, is_rendering, sprite_height, addr_increment, grayscale_mask, selected_palette);
+  dump_snapshot(out, frames[ready_frame], frames[work_frame]);
+}
+
+void Ppu::load(utility::SnapshotReader& in) {
+  get_snapshot(in, ppu_state, ppu_addr, bus_latch, ppudata_buffer, addr_latch);
+  get_snapshot(in, ci_ram, cg_ram, oam_mem);
+
+  for (auto* sprites : {&oam, &sec_oam}) {
+    for (auto& sprite : *sprites) {
+      get_snapshot(in, sprite.y, sprite.tile, sprite.attr, sprite.x, sprite.id, sprite.data);
+    }
+  }
+
+  get_snapshot(in, vram_addr, temp_addr, fine_x, oam_addr, ctrl, mask, status);
+  get_snapshot(in, nt_latch, at_latch, bg_latch, at_shift, bg_shift, at_bits);
+  get_snapshot(in, scanline, tick, is_odd_frame);
+  get_snapshot(in, is_rendering, sprite_height, addr_increment, grayscale_mask, selected_palette);
+
+  ready_frame = 0;
+  work_frame = 1;
+  get_snapshot(in, frames[ready_frame], frames[work_frame]);
+  is_frame_buffer_stale = true;
+
+  // Everything below selects a branch, a shift or an index when drawing
+  if (ppu_state > Timing::PreRender) {
+    throw std::runtime_error("Invalid snapshot: PPU state out of range");
+  }
+
+  if (scanline > 261 || tick > 340) {
+    throw std::runtime_error("Invalid snapshot: dot out of range");
+  }
+
+  if (sprite_height != 8 && sprite_height != 16) {
+    throw std::runtime_error("Invalid snapshot: sprite height out of range");
+  }
+
+  if (fine_x > 7 || (grayscale_mask != 0x30 && grayscale_mask != 0x3F)) {
+    throw std::runtime_error("Invalid snapshot: scroll or grayscale out of range");
+  }
+
+  if (selected_palette >= full_nes_palette.size()) {
+    throw std::runtime_error("Invalid snapshot: colour emphasis out of range");
+  }
+
+  for (const auto* frame : {&frames[ready_frame], &frames[work_frame]}) {
+    if (frame->emphasis >= full_nes_palette.size()) {
+      throw std::runtime_error("Invalid snapshot: frame colour emphasis out of range");
+    }
+
+    if (std::ranges::any_of(frame->pixels, [](const u8 pixel) { return pixel > 0x3F; })) {
+      throw std::runtime_error("Invalid snapshot: frame colour out of range");
+    }
+  }
+
+  is_sprite_index_stale = true;
+  update_sprite_line();
+
+  update_nametables(); // The cartridge is loaded first
+}
+
+void Ppu::update_nametables() {
+  nametables = cartridge->get_nametable_pages(ci_ram);
 }
 
 void Ppu::step() {
@@ -117,16 +232,93 @@ void Ppu::step() {
     default: unreachable();
   }
 
+  next_dot();
+}
+
+void Ppu::run(i32 dots) {
+  while (dots > 0) {
+    if (ppu_state == Timing::Idle || (ppu_state == Timing::VBlank && tick > 1)) {
+      // Nothing happens until the end of the scanline
+      const auto skipped = std::min(dots, 341 - tick);
+      tick += static_cast<u16>(skipped - 1);
+      dots -= skipped;
+      next_dot();
+      continue;
+    }
+
+    if constexpr (SCANLINE_RENDERER) {
+      if (ppu_state == Timing::Visible) {
+        // The CPU catches the PPU up before touching its registers or the mapper, so nothing
+        // can change while these dots run and the pixels can be drawn in a single pass
+        if (tick == 1 && dots >= 257) {
+          render_scanline();
+          tick += 256;
+          dots -= 257;
+          next_dot();
+          continue;
+        }
+
+        // Nothing happens between the mapper IRQ and the sprite fetches
+        if (tick > 260 && tick < 321) {
+          const auto skipped = std::min(dots, 321 - tick);
+          tick += static_cast<u16>(skipped - 1);
+          dots -= skipped;
+          next_dot();
+          continue;
+        }
+      }
+    }
+
+    step();
+    --dots;
+  }
+}
+
+auto Ppu::dots_until_event() const -> i32 {
+  // NMI
+  auto dots = dots_until(241, 1);
+
+  // Mapper IRQ (clocked on dot 260 of the rendering scanlines)
+  if (is_rendering && cartridge->has_scanline_irq()) {
+    if ((scanline < 240 || scanline == 261) && tick <= 260) {
+      dots = std::min(dots, dots_until(scanline, 260));
+    } else if (scanline < 239) {
+      dots = std::min(dots, dots_until(static_cast<u16>(scanline + 1), 260));
+    } else if (scanline < 261) {
+      dots = std::min(dots, dots_until(261, 260));
+    } else {
+      dots = std::min(dots, dots_until(0, 260));
+    }
+  }
+
+  return dots;
+}
+
+auto Ppu::dots_until(const u16 target_scanline, const u16 target_tick) const -> i32 {
+  constexpr i32 dots_per_frame = 341 * 262;
+
+  const i32 current = (scanline * 341) + tick;
+  const i32 target = (target_scanline * 341) + target_tick;
+
+  if (target >= current) {
+    return target - current + 1;
+  }
+
+  // Wraps around the frame; assume the odd frame cycle skip so the event is never overshot
+  return dots_per_frame - current + target;
+}
+
+void Ppu::next_dot() {
   ++tick;
   if (tick > 340) {
     tick = 0;
     ++scanline;
 
     if (scanline == 240) {
-      frame_buffer = work_frame_buffer;
-      std::ranges::transform(frame_buffer, frame_buffer.begin(), [this](const u32 p) {
-        return full_nes_palette[mask.rgb()][p];
-      });
+      frames[work_frame].emphasis = mask.rgb();
+      ready_frame = work_frame;
+      work_frame = (work_frame + 1) % frames.size();
+      is_frame_buffer_stale = true;
       ppu_state = Timing::Idle;
     } else if (scanline == 241) {
       ppu_state = Timing::VBlank;
@@ -234,7 +426,11 @@ void Ppu::write(const u16 addr, const u8 value) {
       ctrl.raw = value;
       temp_addr.set_nt(ctrl.nt());
 
-      sprite_height = ctrl.spr_size() ? 16 : 8;
+      if (const u8 height = ctrl.spr_size() ? 16 : 8; height != sprite_height) {
+        sprite_height = height;
+        is_sprite_index_stale = true;
+      }
+
       addr_increment = ctrl.addr_inc() ? 32 : 1;
       break;
     }
@@ -256,6 +452,7 @@ void Ppu::write(const u16 addr, const u8 value) {
     case OamData: {
       oam_mem[oam_addr] = value;
       ++oam_addr;
+      is_sprite_index_stale = true;
       break;
     }
 
@@ -310,8 +507,8 @@ auto Ppu::vram_read(const u16 addr) const -> u8 {
   using enum types::ppu::MemoryMap;
 
   switch (types::ppu::get_memory_map(addr)) {
-    case Chr: return Cartridge::get().chr_read(addr);
-    case Nametables: return ci_ram[nt_mirror_addr(addr)];
+    case Chr: return cartridge->chr_read(addr);
+    case Nametables: return nametables[(addr >> 10) & 0b11][addr & 0x3FF];
     case Palettes: return cg_ram[palette_addr(addr)] & grayscale_mask;
     case Unknown: return 0;
 
@@ -323,8 +520,8 @@ void Ppu::vram_write(const u16 addr, const u8 value) {
   using enum types::ppu::MemoryMap;
 
   switch (types::ppu::get_memory_map(addr)) {
-    case Chr: Cartridge::get().chr_write(addr, value); break;
-    case Nametables: ci_ram[nt_mirror_addr(addr)] = value; break;
+    case Chr: cartridge->chr_write(addr, value); break;
+    case Nametables: nametables[(addr >> 10) & 0b11][addr & 0x3FF] = value; break;
     case Palettes: cg_ram[palette_addr(addr)] = value; break;
     case Unknown: throw std::runtime_error("Unreachable");
 
@@ -332,35 +529,62 @@ void Ppu::vram_write(const u16 addr, const u8 value) {
   }
 }
 
+void Ppu::write_oam(const std::span<const u8, 0x100> data) {
+  // OAMADDR wraps around to where it started
+  const usize split = oam_mem.size() - oam_addr;
+  std::ranges::copy(data.first(split), oam_mem.begin() + oam_addr);
+  std::ranges::copy(data.subspan(split), oam_mem.begin());
+
+  bus_latch = data.back();
+  is_sprite_index_stale = true;
+}
+
 void Ppu::clear_sec_oam() {
   sec_oam.fill({});
 }
 
 void Ppu::sprite_evaluation() {
-  usize size = 0;
+  if (is_sprite_index_stale) {
+    update_sprite_index();
+  }
 
-  for (usize i = 0; i < 64; ++i) {
-    const i32 line = scanline - oam_mem[i * 4];
+  const auto& sprites = sprite_index[scanline];
 
-    if (line < 0) {
-      continue;
-    }
+  for (usize i = 0; i < sprites.size; ++i) {
+    const usize id = sprites.ids[i];
+
+    sec_oam[i].id = id;
+    sec_oam[i].y = oam_mem[(id * 4) + 0];
+    sec_oam[i].tile = oam_mem[(id * 4) + 1];
+    sec_oam[i].attr = oam_mem[(id * 4) + 2];
+    sec_oam[i].x = oam_mem[(id * 4) + 3];
+  }
+
+  if (sprites.size == sprites.ids.size()) {
+    status.set_spr_overflow(true);
+  }
+}
 
-    if (static_cast<u8>(line) < sprite_height) {
-      sec_oam[size].id = i;
-      sec_oam[size].y = oam_mem[(i * 4) + 0];
-      sec_oam[size].tile = oam_mem[(i * 4) + 1];
-      sec_oam[size].attr = oam_mem[(i * 4) + 2];
-      sec_oam[size].x = oam_mem[(i * 4) + 3];
+void Ppu::update_sprite_index() {
+  for (auto& sprites : sprite_index) {
+    sprites.size = 0;
+  }
+
+  for (usize i = 0; i < 64; ++i) {
+    const usize y = oam_mem[i * 4];
+    const usize end = std::min(y + sprite_height, sprite_index.size());
 
-      ++size;
+    for (usize line = y; line < end; ++line) {
+      auto& sprites = sprite_index[line];
 
-      if (size >= 8) {
-        status.set_spr_overflow(true);
-        return;
+      if (sprites.size < sprites.ids.size()) {
+        sprites.ids[sprites.size] = static_cast<u8>(i);
+        ++sprites.size;
       }
     }
   }
+
+  is_sprite_index_stale = false;
 }
 
 void Ppu::load_sprites() {
@@ -385,35 +609,37 @@ void Ppu::load_sprites() {
       addr += offset + (offset & 8);
     }
 
-    // Fetch sprite data
-    sprite.data_l = vram_read(addr + 0);
-    sprite.data_h = vram_read(addr + 8);
-
-    // Horizontal flip
+    // Fetch sprite data, horizontal flip
     if ((sprite.attr & 0x40) != 0) {
-      // clang-format off
-      constexpr auto lookup_table = std::to_array<u8>({
-          0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0, 0x10, 0x90, 0x50, 0xD0, 0x30, 0xB0, 0x70, 0xF0,
-          0x08, 0x88, 0x48, 0xC8, 0x28, 0xA8, 0x68, 0xE8, 0x18, 0x98, 0x58, 0xD8, 0x38, 0xB8, 0x78, 0xF8,
-          0x04, 0x84, 0x44, 0xC4, 0x24, 0xA4, 0x64, 0xE4, 0x14, 0x94, 0x54, 0xD4, 0x34, 0xB4, 0x74, 0xF4,
-          0x0C, 0x8C, 0x4C, 0xCC, 0x2C, 0xAC, 0x6C, 0xEC, 0x1C, 0x9C, 0x5C, 0xDC, 0x3C, 0xBC, 0x7C, 0xFC,
-          0x02, 0x82, 0x42, 0xC2, 0x22, 0xA2, 0x62, 0xE2, 0x12, 0x92, 0x52, 0xD2, 0x32, 0xB2, 0x72, 0xF2,
-          0x0A, 0x8A, 0x4A, 0xCA, 0x2A, 0xAA, 0x6A, 0xEA, 0x1A, 0x9A, 0x5A, 0xDA, 0x3A, 0xBA, 0x7A, 0xFA,
-          0x06, 0x86, 0x46, 0xC6, 0x26, 0xA6, 0x66, 0xE6, 0x16, 0x96, 0x56, 0xD6, 0x36, 0xB6, 0x76, 0xF6,
-          0x0E, 0x8E, 0x4E, 0xCE, 0x2E, 0xAE, 0x6E, 0xEE, 0x1E, 0x9E, 0x5E, 0xDE, 0x3E, 0xBE, 0x7E, 0xFE,
-          0x01, 0x81, 0x41, 0xC1, 0x21, 0xA1, 0x61, 0xE1, 0x11, 0x91, 0x51, 0xD1, 0x31, 0xB1, 0x71, 0xF1,
-          0x09, 0x89, 0x49, 0xC9, 0x29, 0xA9, 0x69, 0xE9, 0x19, 0x99, 0x59, 0xD9, 0x39, 0xB9, 0x79, 0xF9,
-          0x05, 0x85, 0x45, 0xC5, 0x25, 0xA5, 0x65, 0xE5, 0x15, 0x95, 0x55, 0xD5, 0x35, 0xB5, 0x75, 0xF5,
-          0x0D, 0x8D, 0x4D, 0xCD, 0x2D, 0xAD, 0x6D, 0xED, 0x1D, 0x9D, 0x5D, 0xDD, 0x3D, 0xBD, 0x7D, 0xFD,
-          0x03, 0x83, 0x43, 0xC3, 0x23, 0xA3, 0x63, 0xE3, 0x13, 0x93, 0x53, 0xD3, 0x33, 0xB3, 0x73, 0xF3,
-          0x0B, 0x8B, 0x4B, 0xCB, 0x2B, 0xAB, 0x6B, 0xEB, 0x1B, 0x9B, 0x5B, 0xDB, 0x3B, 0xBB, 0x7B, 0xFB,
-          0x07, 0x87, 0x47, 0xC7, 0x27, 0xA7, 0x67, 0xE7, 0x17, 0x97, 0x57, 0xD7, 0x37, 0xB7, 0x77, 0xF7,
-          0x0F, 0x8F, 0x4F, 0xCF, 0x2F, 0xAF, 0x6F, 0xEF, 0x1F, 0x9F, 0x5F, 0xDF, 0x3F, 0xBF, 0x7F, 0xFF
-      });
-      // clang-format on
-
-      sprite.data_l = lookup_table[sprite.data_l];
-      sprite.data_h = lookup_table[sprite.data_h];
+      sprite.data = cartridge->get_chr_row_flipped(addr);
+    } else {
+      sprite.data = cartridge->get_chr_row(addr);
+    }
+  }
+
+  update_sprite_line();
+}
+
+void Ppu::update_sprite_line() {
+  sprite_line.fill(0);
+
+  for (const auto& sprite : oam) {
+    if (sprite.id == 0xFF) {
+      break;
+    }
+
+    for (usize offset = 0; offset < 8 && sprite.x + offset < sprite_line.size(); ++offset) {
+      auto& pixel = sprite_line[sprite.x + offset];
+      const auto spr_palette = static_cast<u8>((sprite.data >> (14 - (2 * offset))) & 0b11);
+
+      // The first opaque sprite wins, even if it is behind the background
+      if (pixel != 0 || spr_palette == 0) {
+        continue;
+      }
+
+      pixel = static_cast<u8>(16 + (spr_palette | ((sprite.attr & 3) << 2)));
+      pixel |= (sprite.attr & 0x20) != 0 ? SPRITE_BEHIND : 0;
+      pixel |= sprite.id == 0 ? SPRITE_ZERO : 0;
     }
   }
 }
@@ -452,20 +678,16 @@ void Ppu::vertical_update() {
 }
 
 void Ppu::background_shift() {
-  bg_shift_l <<= 1;
-  bg_shift_h <<= 1;
-  at_shift_l = static_cast<u8>(at_shift_l << 1) | at_latch_l;
-  at_shift_h = static_cast<u8>(at_shift_h << 1) | at_latch_h;
+  bg_shift <<= 2;
+  at_shift = static_cast<u16>(at_shift << 2) | at_bits;
 
   // Reload shift registers
   if (tick % 8 == 1) {
-    bg_shift_l = (bg_shift_l & 0xFF00) | bg_latch_l;
-    bg_shift_h = (bg_shift_h & 0xFF00) | bg_latch_h;
+    bg_shift = (bg_shift & 0xFFFF'0000) | bg_latch;
 
     at_latch >>= 2 * ((vram_addr.coarse_y() & 0x02) | (((vram_addr.coarse_x() - 1) & 0x02) >> 1));
 
-    at_latch_l = at_latch & 1;
-    at_latch_h = (at_latch >> 1) & 1;
+    at_bits = at_latch & 0b11;
   }
 }
 
@@ -473,10 +695,10 @@ auto Ppu::get_background_pixel() const -> u8 {
   const auto pixel = static_cast<u8>(tick - 2);
 
   if (mask.show_bg() && (mask.bg_left() || pixel >= 8)) {
-    u8 bg_palette = get_palette(bg_shift_l, bg_shift_h, 15 - fine_x);
+    auto bg_palette = static_cast<u8>((bg_shift >> (30 - (2 * fine_x))) & 0b11);
 
     if (bg_palette != 0) {
-      const auto attr_palette = get_palette(at_shift_l, at_shift_h, 7 - fine_x);
+      const auto attr_palette = static_cast<u8>((at_shift >> (14 - (2 * fine_x))) & 0b11);
       bg_palette |= attr_palette << 2;
     }
 
@@ -494,51 +716,134 @@ auto Ppu::get_sprite_pixel() -> u8 {
     return bg_palette;
   }
 
-  for (const auto& sprite : oam) {
-    if (sprite.id == 0xFF) {
-      break;
+  const auto spr_pixel = sprite_line[pixel];
+
+  if (spr_pixel == 0) {
+    return bg_palette;
+  }
+
+  if ((spr_pixel & SPRITE_ZERO) != 0 && bg_palette != 0 && pixel != 255) {
+    status.set_spr0_hit(true);
+  }
+
+  // Evaluate priority
+  if ((spr_pixel & SPRITE_BEHIND) == 0 || bg_palette == 0) {
+    return spr_pixel & 0x1F;
+  }
+
+  return bg_palette;
+}
+
+void Ppu::render_pixel() {
+  const usize row_pixel = tick - 2;
+  const usize pixel_pos = static_cast<usize>(scanline * 256u) + row_pixel;
+
+  if (!is_output_enabled) {
+    if (is_rendering) {
+      UNUSED(get_sprite_pixel()); // Sprite 0 hit
     }
 
-    const i32 offset = pixel - sprite.x;
+    return;
+  }
 
-    if (offset < 0 || offset >= 8) {
-      continue; // Not in range
+  if (!is_rendering) {
+    frames[work_frame].pixels[pixel_pos] = vram_read(0x3F00);
+    return;
+  }
+
+  frames[work_frame].pixels[pixel_pos] = vram_read(0x3F00 + get_sprite_pixel());
+}
+
+// Runs dots 1 to 257 of a visible scanline at once, with the same result as the dot loop:
+// the background is fetched a tile (8 dots) at a time. Only valid if nothing outside the PPU
+// changes during these dots.
+void Ppu::render_scanline() {
+  const auto pixels = std::span(frames[work_frame].pixels).subspan(scanline * 256u, 256);
+
+  if (!is_rendering) {
+    if (is_output_enabled) {
+      std::ranges::fill(pixels, vram_read(0x3F00));
     }
 
-    u8 spr_palette = get_palette(sprite.data_l, sprite.data_h, static_cast<u8>(7 - offset));
+    return;
+  }
+
+  std::array<u8, 32> colors = {};
+  for (usize i = 0; i < colors.size(); ++i) {
+    colors[i] = vram_read(static_cast<u16>(0x3F00 + i));
+  }
+
+  // Sprites are hidden in the first 8 pixels by PPUMASK, or all of them
+  const usize spr_start = !mask.show_spr() ? sprite_line.size() : mask.spr_left() ? 0 : 8;
+  const auto spr_pixels = std::span(sprite_line).subspan(spr_start);
 
-    if (spr_palette != 0) {
-      const auto is_sprite0 = sprite.id == 0;
-      const auto spr_priority = (sprite.attr & 0x20) == 0;
-      spr_palette |= (sprite.attr & 3) << 2;
-      spr_palette += 16;
+  const auto has_spr_zero = std::ranges::any_of(spr_pixels, [](const u8 pixel) {
+    return (pixel & SPRITE_ZERO) != 0;
+  });
 
-      if (is_sprite0 && (spr_palette != 0) && (bg_palette != 0) && pixel != 255) {
-        status.set_spr0_hit(true);
+  // Without output the pixels are only evaluated for the sprite 0 hit, never stored
+  const auto evaluate_pixels = is_output_enabled || has_spr_zero;
+
+  clear_sec_oam(); // Dot 1
+
+  for (usize tile = 0; tile < 32; ++tile) {
+    // Fetches (dots 8n+1 to 8n+8)
+    nt_latch = vram_read(nt_addr());
+    at_latch = vram_read(at_addr());
+    ppu_addr = bg_addr() + 8;
+    bg_latch = cartridge->get_chr_row(ppu_addr);
+
+    if (tile < 31) {
+      horizontal_scroll();
+    } else {
+      vertical_scroll(); // Dot 256
+    }
+
+    // Pixels (dots 8n+2 to 8n+9)
+    for (usize i = 0; evaluate_pixels && i < 8; ++i) {
+      const auto x = (tile * 8) + i;
+      const auto shift = fine_x + i;
+
+      u8 bg_palette = 0;
+
+      if (mask.show_bg() && (mask.bg_left() || x >= 8)) {
+        bg_palette = static_cast<u8>((bg_shift >> (30 - (2 * shift))) & 0b11);
+
+        if (bg_palette != 0) {
+          const auto attr_palette =
+            shift < 8 ? static_cast<u8>((at_shift >> (14 - (2 * shift))) & 0b11) : at_bits;
+          bg_palette |= attr_palette << 2;
+        }
       }
 
-      // Evaluate priority
-      if ((spr_palette != 0) && (spr_priority || bg_palette == 0)) {
-        return spr_palette;
+      u8 palette = bg_palette;
+
+      if (const auto spr_pixel = x >= spr_start ? sprite_line[x] : u8{0}; spr_pixel != 0) {
+        if ((spr_pixel & SPRITE_ZERO) != 0 && bg_palette != 0 && x != 255) {
+          status.set_spr0_hit(true);
+        }
+
+        if ((spr_pixel & SPRITE_BEHIND) == 0 || bg_palette == 0) {
+          palette = spr_pixel & 0x1F;
+        }
       }
 
-      return bg_palette;
+      if (is_output_enabled) {
+        pixels[x] = colors[palette];
+      }
     }
-  }
 
-  return bg_palette;
-}
+    // Shift registers after 8 dots, then reload (dot 8n+9)
+    bg_shift = (bg_shift << 16) | bg_latch;
+    at_shift = static_cast<u16>(at_bits * 0x5555);
 
-void Ppu::render_pixel() {
-  const usize row_pixel = tick - 2;
-  const usize pixel_pos = static_cast<usize>(scanline * 256u) + row_pixel;
+    at_latch >>= 2 * ((vram_addr.coarse_y() & 0x02) | (((vram_addr.coarse_x() - 1) & 0x02) >> 1));
 
-  if (!is_rendering) {
-    work_frame_buffer[pixel_pos] = vram_read(0x3F00);
-    return;
+    at_bits = at_latch & 0b11;
   }
 
-  work_frame_buffer[pixel_pos] = vram_read(0x3F00 + get_sprite_pixel());
+  horizontal_update(); // Dot 257
+  sprite_evaluation();
 }
 
 void Ppu::background_fetch() {
@@ -558,12 +863,13 @@ void Ppu::background_fetch() {
       case 3: ppu_addr = at_addr(); break;
       case 4: at_latch = vram_read(ppu_addr); break;
 
+      // Each bitplane still comes from its own fetch, as the CHR banks may switch in between
       case 5: ppu_addr = bg_addr(); break;
-      case 6: bg_latch_l = vram_read(ppu_addr); break;
+      case 6: bg_latch = cartridge->get_chr_row(ppu_addr) & 0x5555; break;
 
       case 7: ppu_addr += 8; break;
       case 0:
-        bg_latch_h = vram_read(ppu_addr);
+        bg_latch = static_cast<u16>(bg_latch | (cartridge->get_chr_row(ppu_addr) & 0xAAAA));
         horizontal_scroll();
         break;
 
@@ -572,7 +878,7 @@ void Ppu::background_fetch() {
   } else {
     switch (tick) {
       case 256:
-        bg_latch_h = vram_read(ppu_addr);
+        bg_latch = static_cast<u16>(bg_latch | (cartridge->get_chr_row(ppu_addr) & 0xAAAA));
         vertical_scroll();
         break;
 
@@ -607,7 +913,7 @@ void Ppu::scanline_cycle_pre() {
       load_sprites();
     }
     if (tick == 260) {
-      Cartridge::get().scanline_counter();
+      cartridge->scanline_counter();
     }
   }
 }
@@ -628,7 +934,7 @@ void Ppu::scanline_cycle_visible() {
     }
 
     if (tick == 260) {
-      Cartridge::get().scanline_counter();
+      cartridge->scanline_counter();
     }
   }
 }
@@ -662,29 +968,7 @@ auto Ppu::bg_addr() const -> u16 {
   return (static_cast<u16>(ctrl.bg_table()) * 0x1000) + (nt_latch * 16) + vram_addr.fine_y();
 }
 
-auto Ppu::nt_mirror_addr(const u16 addr) const -> u16 {
-  using enum types::ppu::MirroringType;
-
-  switch (Cartridge::get().get_mirroring()) {
-    case Vertical: return addr & 0x07FF;
-    case Horizontal: return ((addr >> 1) & 0x400) + (addr & 0x03FF);
-    case OneScreenLow: return addr & 0x03FF;
-    case OneScreenHigh: return 0x0400 + (addr & 0x03FF);
-    case FourScreen: return addr & 0x0FFF;
-    case Unknown: throw std::runtime_error("Invalid mirroring type");
-
-    default: unreachable();
-  }
-}
-
 auto Ppu::palette_addr(const u16 addr) -> u16 {
   return (((addr & 0x13) == 0x10) ? (addr & ~0x10) : addr) & 0x1F;
 }
-
-template <typename T>
-auto Ppu::get_palette(T low, T high, u8 offset) const -> u8 {
-  constexpr auto nth_bit = [](auto x, auto n) -> u8 { return ((x >> n) & 1); };
-
-  return static_cast<u8>(nth_bit(high, offset) << 1) | nth_bit(low, offset);
-}
 } // namespace nes
@@ -2,27 +2,52 @@
 
 #include <array>
 #include <memory>
+#include <span>
 #include <vector>
 
 #include "lib/common.hpp"
 #include "types/ppu_types.hpp"
+#include "utility/snapshotable.hpp"
 
 namespace nes {
-class Ppu final {
+class Cartridge;
+
+class Ppu final: public utility::Snapshotable {
 public:
-  static auto get() -> Ppu&;
+  explicit Ppu(Cartridge& cartridge_ref);
 
   void power_on();
   void reset();
 
-  [[nodiscard]] auto get_frame_buffer() const -> const u32*;
+  // Fetches the nametable pages from the cartridge again, after the mapper changed the mirroring
+  void update_nametables();
+
+  // Last complete frame. The RGB conversion only runs when the colours are requested.
+  [[nodiscard]] auto get_frame_buffer() -> const u32*;
+  [[nodiscard]] auto get_frame_indices() const -> std::span<const u8>; // Palette indices
+  [[nodiscard]] auto get_frame_emphasis() const -> u8;                  // PPUMASK colour emphasis
 
   void set_palette(const std::vector<u8>& palette);
 
+  // Without output the pixels aren't drawn (the frames keep their old contents), but everything
+  // the CPU can observe, like the sprite 0 hit, still happens
+  void set_output_enabled(bool enabled);
+
   auto read(u16 addr) -> u8;
   void write(u16 addr, u8 value);
 
+  // OAM DMA: same as writing the 256 bytes to OAMDATA
+  void write_oam(std::span<const u8, 0x100> data);
+
+  // Registers, memories, rendering state and the frame being drawn
+  void save(utility::SnapshotWriter& out) const override;
+  void load(utility::SnapshotReader& in) override;
+
   void step();
+  void run(i32 dots); // Catch-up: runs several dots at once
+
+  // Number of dots that can run before the PPU may raise an NMI or a mapper IRQ
+  [[nodiscard]] auto dots_until_event() const -> i32;
 
   std::shared_ptr<bool> nmi;
 
@@ -42,7 +67,7 @@ public:
   [[nodiscard]] auto peek_vram(u16 addr) const -> u8;
 
 private:
-  Ppu() = default;
+  Cartridge* cartridge;
 
   //
   // VRAM access
@@ -59,6 +84,9 @@ private:
   void sprite_evaluation(); // Fill the secondary OAM with new sprites
   void load_sprites();      // Load the sprites into the primary OAM
 
+  void update_sprite_index(); // Bucket the OAM sprites by scanline
+  void update_sprite_line();  // Merge the primary OAM into the sprite line buffer
+
   //
   // Scrolling
   //
@@ -77,6 +105,10 @@ private:
   [[nodiscard]] auto get_sprite_pixel() -> u8;
 
   void render_pixel();
+  void render_scanline(); // Scanline renderer (ENABLE_PPU_SCANLINE_RENDERER)
+
+  void next_dot(); // Advance the dot and scanline counters
+  [[nodiscard]] auto dots_until(u16 target_scanline, u16 target_tick) const -> i32;
 
   //
   // Scanline cycles and background operations
@@ -93,14 +125,10 @@ private:
   // Addresses
   //
 
-  [[nodiscard]] auto nt_addr() const -> u16;                // Nametable address
-  [[nodiscard]] auto at_addr() const -> u16;                // Attribute address
-  [[nodiscard]] auto bg_addr() const -> u16;                // Background address
-  [[nodiscard]] static auto palette_addr(u16 addr) -> u16;  // Palette address
-  [[nodiscard]] auto nt_mirror_addr(u16 addr) const -> u16; // Relative nametable address
-
-  template <typename T>
-  [[nodiscard]] auto get_palette(T low, T high, u8 offset) const -> u8; // Get palette
+  [[nodiscard]] auto nt_addr() const -> u16;               // Nametable address
+  [[nodiscard]] auto at_addr() const -> u16;               // Attribute address
+  [[nodiscard]] auto bg_addr() const -> u16;               // Background address
+  [[nodiscard]] static auto palette_addr(u16 addr) -> u16; // Palette address
 
   enum class Timing {
     Idle,
@@ -135,17 +163,47 @@ private:
 
   using FrameBufferType = std::array<u32, 256 * 240>;
 
+  struct Frame {
+    std::array<u8, 256 * 240> pixels = {}; // Palette indices
+    u8 emphasis = 0;                       // PPUMASK colour emphasis when the frame ended
+  };
+
   using FullNesPaletteType = std::array<std::array<u32, 64>, 8>;
 
   CiRamType ci_ram = {};   // Console-Internal RAM
   CgRamType cg_ram = {};   // Colour generator RAM
   OamMemType oam_mem = {}; // Object Attribute Memory (sprites)
 
+  // Nametable pages at $2000, $2400, $2800 and $2C00, from the cartridge. The mirroring only
+  // changes when the mapper is written, so they aren't looked up on every fetch.
+  std::array<u8*, 4> nametables = {};
+
   OamType oam = {};        // Sprite buffer
   SecOamType sec_oam = {}; // Secondary sprite buffer
 
-  FrameBufferType frame_buffer = {};      // Frame buffer
-  FrameBufferType work_frame_buffer = {}; // Back buffer
+  // The first 8 sprites of every visible scanline, in OAM order. OAM rarely changes more than
+  // once per frame, so this is rebuilt on demand instead of scanning the 64 sprites every line.
+  struct ScanlineSprites {
+    std::array<u8, 8> ids = {};
+    u8 size = 0;
+  };
+
+  std::array<ScanlineSprites, 240> sprite_index = {};
+  bool is_sprite_index_stale = true;
+
+  // Sprite pixels of the line being drawn, from the primary OAM: palette index (0 when
+  // transparent), with the priority and sprite 0 flags in the top bits
+  std::array<u8, 256> sprite_line = {};
+
+  // Frames are swapped by index, the PPU draws into `work_frame` while `ready_frame` and the
+  // one before it stay untouched for consumers
+  std::array<Frame, 3> frames = {};
+  usize work_frame = 0;
+  usize ready_frame = frames.size() - 1;
+
+  FrameBufferType frame_buffer = {}; // RGB conversion of the ready frame
+  bool is_frame_buffer_stale = true;
+  bool is_output_enabled = true;
 
   FullNesPaletteType full_nes_palette = {};
   u8 selected_palette = 0;
@@ -164,19 +222,17 @@ private:
   // Background latches
   //
 
-  u8 nt_latch = 0;   // Nametable latch
-  u8 at_latch = 0;   // Attribute latch
-  u8 bg_latch_l = 0; // Background latch (low)
-  u8 bg_latch_h = 0; // Background latch (high)
+  // Tile data is kept decoded (2 bits per pixel, leftmost pixel in the top bits),
+  // so that a pixel is a single shift and mask
 
-  u8 at_shift_l = 0; // Attribute shift register (low)
-  u8 at_shift_h = 0; // Attribute shift register (high)
+  u8 nt_latch = 0;  // Nametable latch
+  u8 at_latch = 0;  // Attribute latch
+  u16 bg_latch = 0; // Background latch (tile row)
 
-  u16 bg_shift_l = 0; // Background shift register (low)
-  u16 bg_shift_h = 0; // Background shift register (high)
+  u16 at_shift = 0; // Attribute shift register (8 pixels)
+  u32 bg_shift = 0; // Background shift register (16 pixels)
 
-  u8 at_latch_l = 0; // Attribute latch (low)
-  u8 at_latch_h = 0; // Attribute latch (high)
+  u8 at_bits = 0; // Attribute of the next tile
 
   //
   // Rendering counters
@@ -0,0 +1,149 @@
+#include "nes/rewind.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "lib/common.hpp"
+#include "nes/nes.hpp"
+#include "utility/xor_rle.hpp"
+
+namespace nes {
+namespace {
+  constexpr usize FRAMES_PER_MINUTE = 60 * 60;
+} // namespace
+
+Rewind::Rewind(const usize budget, const usize state_interval, const usize keyframe_spacing) :
+  memory_budget(budget),
+  interval(state_interval),
+  keyframe_interval(keyframe_spacing) {
+  if (interval == 0 || keyframe_interval == 0) {
+    throw std::invalid_argument("Rewind intervals must be greater than zero");
+  }
+}
+
+void Rewind::push(const Nes& nes) {
+  if (frame_count % interval != 0) {
+    ++frame_count;
+    return;
+  }
+
+  nes.save_state(state);
+  push(state);
+}
+
+void Rewind::push(const std::span<const u8> nes_state) {
+  if (frame_count++ % interval != 0) {
+    return;
+  }
+
+  // States only change size when another ROM is loaded, which restarts the chain
+  const auto is_keyframe = entries.empty() || deltas_since_keyframe + 1 >= keyframe_interval ||
+                           nes_state.size() != keyframe.size();
+
+  auto& entry = entries.emplace_back(is_keyframe, std::vector<u8>{});
+
+  if (is_keyframe) {
+    utility::xor_rle_encode(nes_state, {}, entry.data);
+    keyframe.assign(nes_state.begin(), nes_state.end());
+    deltas_since_keyframe = 0;
+  } else {
+    utility::xor_rle_encode(nes_state, keyframe, entry.data);
+    ++deltas_since_keyframe;
+  }
+
+  entry.data.shrink_to_fit();
+  used += entry.data.size();
+
+  evict();
+}
+
+auto Rewind::step_back(Nes& nes) -> bool {
+  if (entries.empty()) {
+    return false;
+  }
+
+  auto entry = std::move(entries.back());
+  entries.pop_back();
+  used -= entry.data.size();
+
+  if (entry.is_keyframe) {
+    utility::xor_rle_decode(entry.data, {}, state);
+    nes.load_state(state);
+    decode_last_keyframe();
+  } else {
+    utility::xor_rle_decode(entry.data, keyframe, state);
+    nes.load_state(state);
+    --deltas_since_keyframe;
+  }
+
+  // Keeps the interval aligned, so that the next push stores a state
+  frame_count = 0;
+
+  return true;
+}
+
+void Rewind::clear() {
+  entries.clear();
+  keyframe.clear();
+  used = 0;
+  frame_count = 0;
+  deltas_since_keyframe = 0;
+}
+
+auto Rewind::size() const -> usize {
+  return entries.size();
+}
+
+auto Rewind::memory_usage() const -> usize {
+  return used;
+}
+
+auto Rewind::memory_per_minute() const -> usize {
+  if (entries.empty()) {
+    return 0;
+  }
+
+  return used * FRAMES_PER_MINUTE / (entries.size() * interval);
+}
+
+// Drops the oldest keyframe and its deltas while over budget, always keeping the newest one
+void Rewind::evict() {
+  while (used > memory_budget) {
+    const auto next_keyframe = std::find_if(
+      std::next(entries.begin()),
+      entries.end(),
+      [](const Entry& entry) { return entry.is_keyframe; }
+    );
+
+    if (next_keyframe == entries.end()) {
+      return;
+    }
+
+    for (auto it = entries.begin(); it != next_keyframe; ++it) {
+      used -= it->data.size();
+    }
+
+    entries.erase(entries.begin(), next_keyframe);
+  }
+}
+
+// Called after the newest keyframe was stepped over, so the deltas before it can be decoded
+void Rewind::decode_last_keyframe() {
+  const auto last = std::find_if(entries.rbegin(), entries.rend(), [](const Entry& entry) {
+    return entry.is_keyframe;
+  });
+
+  if (last == entries.rend()) {
+    keyframe.clear();
+    deltas_since_keyframe = 0;
+    return;
+  }
+
+  utility::xor_rle_decode(last->data, {}, keyframe);
+  deltas_since_keyframe = static_cast<usize>(std::distance(entries.rbegin(), last));
+}
+} // namespace nes
@@ -0,0 +1,66 @@
+#include "nes/run_ahead.hpp"
+
+#include <format>
+#include <span>
+#include <stdexcept>
+
+#include "lib/common.hpp"
+#include "nes/nes.hpp"
+
+namespace nes {
+RunAhead::RunAhead(const usize frame_count) : frames(MIN_FRAMES) {
+  set_frames(frame_count);
+}
+
+auto RunAhead::get_frames() const -> usize {
+  return frames;
+}
+
+void RunAhead::set_frames(const usize value) {
+  if (value < MIN_FRAMES || value > MAX_FRAMES) {
+    throw std::invalid_argument(
+      std::format("Run-ahead frames must be between {} and {}", MIN_FRAMES, MAX_FRAMES)
+    );
+  }
+
+  frames = value;
+}
+
+void RunAhead::run_frame(Nes& nes) {
+  restore(nes);
+
+  // Real frame. It is drawn so that its state is complete, e.g. for rewinding, and it is the
+  // only one heard.
+  nes.run_frame();
+  nes.save_state(state);
+
+  const auto is_audio_enabled = nes.is_audio_enabled();
+  nes.set_audio_enabled(false);
+
+  // Frames ahead, only the last one is shown
+  for (usize i = 1; i <= frames; ++i) {
+    nes.set_output_enabled(Nes::needs_output(frames - i));
+    nes.run_frame();
+  }
+
+  nes.set_output_enabled(true);
+  nes.set_audio_enabled(is_audio_enabled);
+
+  is_ahead = true;
+}
+
+void RunAhead::restore(Nes& nes) {
+  if (is_ahead) {
+    nes.load_state(state);
+    is_ahead = false;
+  }
+}
+
+void RunAhead::clear() {
+  is_ahead = false;
+}
+
+auto RunAhead::get_state() const -> std::span<const u8> {
+  return state;
+}
+} // namespace nes
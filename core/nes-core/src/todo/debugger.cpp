@@ -15,7 +15,7 @@
 namespace nes {
 using namespace types::cpu;
 
-// debugger::debugger(emulator& emu_ref) : emu(emu_ref) {}
+Debugger::Debugger(const Cpu& cpu_ref, const Ppu& ppu_ref) : cpu(&cpu_ref), ppu(&ppu_ref) {}
 
 void Debugger::cpu_log() {
   // clang-format off
@@ -62,26 +62,24 @@ void Debugger::cpu_log() {
   };
   // clang-format on
 
-  const auto& cpu = Cpu::get();
-
-  auto peek = [&](const u16 addr) { return cpu.peek(addr); };
-  auto peek_imm = [&] { return cpu.peek_imm(); };
-  auto peek_rel = [&] { return cpu.peek_rel(); };
-  auto peek_zp = [&] { return cpu.peek_zp(); };
-  auto peek_zpx = [&] { return cpu.peek_zpx(); };
-  auto peek_zpy = [&] { return cpu.peek_zpy(); };
-  auto peek_ab = [&] { return cpu.peek_ab(); };
-  auto peek_abx = [&] { return cpu.peek_abx(); };
-  auto peek_aby = [&] { return cpu.peek_aby(); };
-  auto peek_ind = [&] { return cpu.peek_ind(); };
-  auto peek_indx = [&] { return cpu.peek_indx(); };
-  auto peek_indy = [&] { return cpu.peek_indy(); };
+  auto peek = [&](const u16 addr) { return cpu->peek(addr); };
+  auto peek_imm = [&] { return cpu->peek_imm(); };
+  auto peek_rel = [&] { return cpu->peek_rel(); };
+  auto peek_zp = [&] { return cpu->peek_zp(); };
+  auto peek_zpx = [&] { return cpu->peek_zpx(); };
+  auto peek_zpy = [&] { return cpu->peek_zpy(); };
+  auto peek_ab = [&] { return cpu->peek_ab(); };
+  auto peek_abx = [&] { return cpu->peek_abx(); };
+  auto peek_aby = [&] { return cpu->peek_aby(); };
+  auto peek_ind = [&] { return cpu->peek_ind(); };
+  auto peek_indx = [&] { return cpu->peek_indx(); };
+  auto peek_indy = [&] { return cpu->peek_indy(); };
 
   auto read_word_zp = [&](const u16 addr) -> u16 {
     return peek((addr + 1) & 0xFF) << 8 | peek(addr);
   };
 
-  const auto state = cpu.get_state();
+  const auto state = cpu->get_state();
 
   std::stringstream ss;
 
@@ -190,8 +188,8 @@ void Debugger::cpu_log() {
     default: ss << " "; break;
   }
 
-  auto ppu_cycle = Ppu::get().cycle_count();
-  auto ppu_scanline = Ppu::get().scanline_count();
+  auto ppu_cycle = ppu->cycle_count();
+  auto ppu_scanline = ppu->scanline_count();
 
   ss << std::format(
     "A:{:02X} X:{:02X} Y:{:02X} P:{:02X} SP:{:02X} PPU:{:3d},{:3d} "
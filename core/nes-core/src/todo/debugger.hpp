@@ -3,13 +3,19 @@
 #include <fstream>
 
 namespace nes {
+class Cpu;
+class Ppu;
+
 class Debugger final {
 public:
-  Debugger() = default;
+  Debugger(const Cpu& cpu_ref, const Ppu& ppu_ref);
 
   void cpu_log();
 
 private:
+  const Cpu* cpu;
+  const Ppu* ppu;
+
   std::ofstream nestest_log;
 };
 } // namespace nes
@@ -10,6 +10,11 @@ enum class InterruptionType {
   Brk,
 };
 
+enum class Dispatch {
+  Switch, // `switch` on the opcode
+  Table,  // Table of handlers built at compile time
+};
+
 enum class AddressingMode {
   Invalid = -1,
   Implicit,
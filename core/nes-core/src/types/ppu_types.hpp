@@ -17,8 +17,7 @@ struct SpriteInfo {
   u8 x = 0xFF;    // X position
 
   usize id = 0xFF; // Index in OAM
-  u8 data_l = 0;   // Tile data (low)
-  u8 data_h = 0;   // Tile data (high)
+  u16 data = 0;    // Tile row, 2 bits per pixel (see Cartridge::get_chr_row)
 };
 
 enum class PpuMap {
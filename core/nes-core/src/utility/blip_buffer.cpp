@@ -0,0 +1,128 @@
+#include "blip_buffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <span>
+#include <vector>
+
+#include "lib/common.hpp"
+
+namespace nes::utility {
+namespace {
+  constexpr double CUTOFF = 0.45;      // Of the sample rate, just below Nyquist
+  constexpr double HIGHPASS_HZ = 90.0; // Like the NES output stage
+  constexpr double MAX_LATENCY = 0.25; // Seconds of unread samples kept
+} // namespace
+
+BlipBuffer::BlipBuffer(const double clock_rate, const u32 sample_rate) :
+  kernel(make_kernel()),
+  factor(static_cast<usize>(std::ldexp(sample_rate / clock_rate, FRAC_BITS))),
+  max_samples(static_cast<usize>(sample_rate * MAX_LATENCY)),
+  deltas(max_samples + (sample_rate / 10) + KERNEL_WIDTH),
+  highpass_factor(
+    static_cast<float>(std::exp(-2.0 * std::numbers::pi * HIGHPASS_HZ / sample_rate))
+  ) {}
+
+void BlipBuffer::clear() {
+  std::ranges::fill(deltas, 0.0F);
+  offset = 0;
+  integrator = 0.0F;
+  highpass_input = 0.0F;
+  highpass_output = 0.0F;
+}
+
+void BlipBuffer::add_delta(const u32 clock_time, const float delta) {
+  const auto position = offset + (clock_time * factor);
+  const auto index = position >> FRAC_BITS;
+  const auto phase = (position >> (FRAC_BITS - PHASE_BITS)) & (PHASES - 1);
+
+  if (index + KERNEL_WIDTH > deltas.size()) {
+    return; // Frame longer than the buffer, only possible with bogus clock times
+  }
+
+  const auto& taps = kernel[phase];
+
+  for (usize i = 0; i < KERNEL_WIDTH; ++i) {
+    deltas[index + i] += taps[i] * delta;
+  }
+}
+
+void BlipBuffer::end_frame(const u32 clock_duration) {
+  offset += clock_duration * factor;
+
+  if (samples_available() > max_samples) {
+    discard_samples(samples_available() - max_samples);
+  }
+}
+
+auto BlipBuffer::samples_available() const -> usize {
+  return offset >> FRAC_BITS;
+}
+
+auto BlipBuffer::read_samples(const std::span<float> out) -> usize {
+  const auto count = std::min(out.size(), samples_available());
+
+  for (usize i = 0; i < count; ++i) {
+    integrator += deltas[i];
+
+    // One-pole high-pass, removes the DC offset of the mixer
+    highpass_output = highpass_factor * (highpass_output + integrator - highpass_input);
+    highpass_input = integrator;
+
+    out[i] = highpass_output;
+  }
+
+  remove_samples(count);
+
+  return count;
+}
+
+void BlipBuffer::discard_samples(const usize count) {
+  for (usize i = 0; i < count; ++i) {
+    integrator += deltas[i];
+  }
+
+  highpass_input = integrator;
+  remove_samples(count);
+}
+
+void BlipBuffer::remove_samples(const usize count) {
+  // The deltas of the next samples (and the kernel tails) move to the front
+  const auto remaining = samples_available() - count + KERNEL_WIDTH;
+  std::copy_n(deltas.begin() + static_cast<std::ptrdiff_t>(count), remaining, deltas.begin());
+  std::fill_n(deltas.begin() + static_cast<std::ptrdiff_t>(remaining), count, 0.0F);
+
+  offset -= count << FRAC_BITS;
+}
+
+// Windowed sinc (Blackman), one row per sub-sample phase, each normalised to a unit step
+auto BlipBuffer::make_kernel() -> Kernel {
+  Kernel result = {};
+
+  for (usize phase = 0; phase < PHASES; ++phase) {
+    const auto fraction = static_cast<double>(phase) / PHASES;
+    auto& taps = result[phase];
+    double sum = 0.0;
+
+    for (usize i = 0; i < KERNEL_WIDTH; ++i) {
+      const auto t = static_cast<double>(i) - (KERNEL_WIDTH / 2.0) + 1.0 - fraction;
+      const auto x = 2.0 * CUTOFF * t;
+      const auto sinc = t == 0.0 ? 1.0 : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+
+      const auto w = (t + (KERNEL_WIDTH / 2.0)) / KERNEL_WIDTH; // 0..1 across the kernel
+      const auto window = 0.42 - (0.5 * std::cos(2.0 * std::numbers::pi * w)) +
+                          (0.08 * std::cos(4.0 * std::numbers::pi * w));
+
+      taps[i] = static_cast<float>(sinc * window);
+      sum += sinc * window;
+    }
+
+    for (auto& tap : taps) {
+      tap = static_cast<float>(static_cast<double>(tap) / sum);
+    }
+  }
+
+  return result;
+}
+} // namespace nes::utility
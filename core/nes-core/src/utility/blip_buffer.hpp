@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <vector>
+
+#include "lib/common.hpp"
+
+namespace nes::utility {
+// Band-limited step synthesis: instead of sampling the signal on every clock, every change of
+// amplitude is added as a band-limited step at its exact (sub-sample) position. The cost
+// depends on the number of changes, not on the clock rate.
+class BlipBuffer final {
+public:
+  BlipBuffer(double clock_rate, u32 sample_rate);
+
+  void clear();
+
+  // `clock_time` is relative to the start of the current frame
+  void add_delta(u32 clock_time, float delta);
+
+  // Ends the frame after `clock_duration` clocks, its samples can be read afterwards
+  void end_frame(u32 clock_duration);
+
+  [[nodiscard]] auto samples_available() const -> usize;
+
+  // Returns the number of samples written to `out`
+  auto read_samples(std::span<float> out) -> usize;
+
+private:
+  static constexpr usize KERNEL_WIDTH = 16;
+  static constexpr u32 PHASE_BITS = 5;
+  static constexpr usize PHASES = usize{1} << PHASE_BITS;
+  static constexpr u32 FRAC_BITS = 32; // Fixed point sample positions
+
+  using Kernel = std::array<std::array<float, KERNEL_WIDTH>, PHASES>;
+
+  [[nodiscard]] static auto make_kernel() -> Kernel;
+
+  void discard_samples(usize count); // Drops unread samples
+  void remove_samples(usize count);  // Shifts the buffer after reading or dropping
+
+  Kernel kernel;
+
+  // Fixed point, 64 bits on every supported target
+  usize factor;     // Samples per clock
+  usize offset = 0; // Position of the current frame's start, from the first unread sample
+
+  usize max_samples; // Samples kept if nobody reads them
+  std::vector<float> deltas;
+
+  float integrator = 0.0F;
+  float highpass_input = 0.0F;
+  float highpass_output = 0.0F;
+  float highpass_factor;
+};
+} // namespace nes::utility
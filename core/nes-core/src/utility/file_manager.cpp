@@ -11,13 +11,9 @@
 #include "ips_patch.hpp"
 #include "lib/common.hpp"
 #include "lib/files.hpp"
+#include "rom_image.hpp"
 
 namespace nes::utility {
-auto FileManager::get() -> FileManager& {
-  static FileManager instance;
-  return instance;
-}
-
 void FileManager::set_app_path(const std::filesystem::path& value) {
   app_path = std::filesystem::canonical(value); // May throw
   set_palette(app_path / "palette.pal");
@@ -50,16 +46,16 @@ void FileManager::set_palette(const std::filesystem::path& value) {
   palette_path = std::filesystem::canonical(value); // May throw
 }
 
-auto FileManager::get_rom() const -> std::vector<u8> {
+auto FileManager::get_rom() const -> RomImage {
   if (!std::filesystem::exists(rom_path)) {
     throw std::invalid_argument("The ROM path needs to be set first");
   }
 
-  auto rom = lib::read_binary_file(rom_path);
+  auto rom = RomImage(rom_path);
 
   if (has_patch()) {
     const auto patch_file = lib::read_binary_file(patch_path);
-    rom = IpsPatch(patch_file).patch(rom);
+    IpsPatch(patch_file).patch(rom);
   }
 
   return rom;
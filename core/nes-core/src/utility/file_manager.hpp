@@ -4,17 +4,16 @@
 #include <vector>
 
 #include "lib/common.hpp"
+#include "rom_image.hpp"
 
 namespace nes::utility {
 class FileManager final {
 public:
-  [[nodiscard]] static auto get() -> FileManager&;
-
   void set_app_path(const std::filesystem::path& value);
   void set_rom(const std::filesystem::path& value);
   void set_palette(const std::filesystem::path& value);
 
-  [[nodiscard]] auto get_rom() const -> std::vector<u8>;
+  [[nodiscard]] auto get_rom() const -> RomImage; // Mapped, with the IPS patch applied
   [[nodiscard]] auto get_prg_ram() const -> std::vector<u8>;
   [[nodiscard]] auto get_palette() const -> std::vector<u8>;
 
@@ -32,8 +31,6 @@ public:
   [[nodiscard]] auto has_snapshot() const -> bool;
 
 private:
-  FileManager() = default;
-
   std::filesystem::path app_path;
   std::filesystem::path rom_path;
   std::filesystem::path patch_path;
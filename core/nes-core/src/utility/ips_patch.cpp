@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "lib/common.hpp"
+#include "rom_image.hpp"
 
 namespace nes::utility {
 IpsPatch::IpsPatch(const std::vector<u8>& patch_file) {
@@ -30,10 +31,12 @@ void IpsPatch::build(const std::vector<u8>& patch_file) {
   }
 }
 
-auto IpsPatch::patch(const std::vector<u8>& rom) -> std::vector<u8> {
-  std::vector<u8> output(std::max(min_size, rom.size()));
+void IpsPatch::patch(RomImage& rom) const {
+  if (rom.size() < min_size) {
+    rom.resize(min_size);
+  }
 
-  std::ranges::copy(rom, output.begin());
+  const auto output = rom.get_data();
 
   for (const auto& [addr, data] : records) {
     std::ranges::copy(data, output.begin() + addr);
@@ -44,12 +47,10 @@ auto IpsPatch::patch(const std::vector<u8>& rom) -> std::vector<u8> {
   //
 
   if (truncate_size) {
-    if (output.size() > *truncate_size) {
-      output.resize(*truncate_size);
+    if (rom.size() > *truncate_size) {
+      rom.resize(*truncate_size);
     }
   }
-
-  return output;
 }
 
 auto IpsPatch::check(std::vector<u8>::const_iterator& iterator) -> bool {
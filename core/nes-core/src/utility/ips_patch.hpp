@@ -4,13 +4,15 @@
 #include <vector>
 
 #include "lib/common.hpp"
+#include "rom_image.hpp"
 
 namespace nes::utility {
 class IpsPatch final {
 public:
   explicit IpsPatch(const std::vector<u8>& patch_file);
 
-  [[nodiscard]] auto patch(const std::vector<u8>& rom) -> std::vector<u8>;
+  // Writes the records over the image, so a mapped ROM only copies the pages they touch
+  void patch(RomImage& rom) const;
 
 private:
   void build(const std::vector<u8>& patch_file);
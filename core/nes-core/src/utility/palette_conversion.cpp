@@ -0,0 +1,35 @@
+#include "palette_conversion.hpp"
+
+#include <span>
+
+#if defined(__AVX2__)
+  #include <immintrin.h>
+#endif
+
+#include "lib/common.hpp"
+
+namespace nes::utility {
+void convert_palette(
+  const std::span<const u8> indices,
+  const ColourPalette& palette,
+  const std::span<u32> colours
+) {
+  usize i = 0;
+
+#if defined(__AVX2__)
+  const auto* table = reinterpret_cast<const int*>(palette.data());
+  const auto index_mask = _mm256_set1_epi32(0x3F); // Same as the scalar loop, stays in the table
+
+  for (; i + 8 <= indices.size(); i += 8) {
+    const auto bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&indices[i]));
+    const auto offsets = _mm256_and_si256(_mm256_cvtepu8_epi32(bytes), index_mask);
+    const auto pixels = _mm256_i32gather_epi32(table, offsets, sizeof(u32));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&colours[i]), pixels);
+  }
+#endif
+
+  for (; i < indices.size(); ++i) {
+    colours[i] = palette[indices[i] & 0x3F];
+  }
+}
+} // namespace nes::utility
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <array>
+#include <span>
+
+#include "lib/common.hpp"
+
+namespace nes::utility {
+using ColourPalette = std::array<u32, 64>;
+
+// Converts palette indices (0x00-0x3F) into colours, 8 pixels at a time with AVX2 when the
+// compiler targets it. `colours` must be at least as big as `indices`.
+void convert_palette(
+  std::span<const u8> indices,
+  const ColourPalette& palette,
+  std::span<u32> colours
+);
+} // namespace nes::utility
@@ -0,0 +1,47 @@
+#include "rom_image.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "lib/common.hpp"
+#include "lib/mapped_file.hpp"
+
+namespace nes::utility {
+RomImage::RomImage(const std::filesystem::path& path) :
+  file(lib::MappedFile(path)),
+  data(file->data()) {}
+
+RomImage::RomImage(std::vector<u8> bytes) : buffer(std::move(bytes)), data(buffer) {}
+
+auto RomImage::get_data() -> std::span<u8> {
+  return data;
+}
+
+auto RomImage::get_data() const -> std::span<const u8> {
+  return data;
+}
+
+auto RomImage::size() const -> usize {
+  return data.size();
+}
+
+void RomImage::resize(const usize new_size) {
+  if (new_size <= data.size()) {
+    data = data.first(new_size);
+    return;
+  }
+
+  if (file) {
+    buffer.assign(data.begin(), data.end());
+    file.reset();
+  } else {
+    buffer.resize(data.size()); // What an earlier shrink cut off doesn't come back
+  }
+
+  buffer.resize(new_size);
+  data = buffer;
+}
+} // namespace nes::utility
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "lib/common.hpp"
+#include "lib/mapped_file.hpp"
+
+namespace nes::utility {
+// The bytes of a ROM file, which the cartridge's PRG and CHR point into. Files are mapped
+// copy-on-write instead of read, so loading costs nothing up front and patching only copies the
+// pages it touches. Moving an image keeps its data in place.
+class RomImage final {
+public:
+  RomImage() = default;
+  explicit RomImage(const std::filesystem::path& path);
+  explicit RomImage(std::vector<u8> bytes); // Built in memory
+
+  [[nodiscard]] auto get_data() -> std::span<u8>;
+  [[nodiscard]] auto get_data() const -> std::span<const u8>;
+  [[nodiscard]] auto size() const -> usize;
+
+  // Shrinking only narrows the view, growing past the mapped file copies it into memory
+  void resize(usize new_size);
+
+private:
+  std::optional<lib::MappedFile> file;
+  std::vector<u8> buffer;
+  std::span<u8> data;
+};
+} // namespace nes::utility
@@ -1,85 +1,111 @@
 #pragma once
 
-#include <array>
-#include <concepts>
-#include <fstream>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
-namespace nes::utility {
-class Snapshotable {
-public:
-  Snapshotable() = default;
-  virtual ~Snapshotable() = default;
+#include "lib/common.hpp"
 
-  Snapshotable(const Snapshotable&) = default;
-  Snapshotable(Snapshotable&&) = default;
-  auto operator=(const Snapshotable&) -> Snapshotable& = default;
-  auto operator=(Snapshotable&&) -> Snapshotable& = default;
+namespace nes::utility {
+// Copied as raw bytes. Types with padding are rejected, since the padding bytes are
+// indeterminate and would make identical states compare different.
+template <typename T>
+concept SnapshotValue =
+  std::is_trivially_copyable_v<T> && std::has_unique_object_representations_v<T>;
 
-  virtual void save(std::ofstream& out) const = 0;
-  virtual void load(std::ifstream& in) = 0;
+// Appends values to a flat byte buffer
+class SnapshotWriter final {
+public:
+  explicit SnapshotWriter(std::vector<u8>& buffer_ref) : buffer(&buffer_ref) {}
 
-protected:
-  template <typename... Args>
-  void dump_snapshot(std::ofstream& out, const Args&... args) const {
-    (dump(out, args), ...);
+  // Integers, enums, registers and arrays of them are copied as a single block
+  template <SnapshotValue T>
+  void write(const T& value) {
+    write_bytes(&value, sizeof(value));
   }
 
-  template <typename... Args>
-  void get_snapshot(std::ifstream& in, Args&&... args) {
-    (get(in, std::forward<Args>(args)), ...);
+  template <SnapshotValue T>
+  void write(const std::vector<T>& vec) {
+    write(vec.size());
+    write_bytes(vec.data(), vec.size() * sizeof(T));
   }
 
 private:
-  //
-  // dump specialisations
-  //
-
-  static void dump(std::ofstream& out, std::integral auto value) {
-    out.write(reinterpret_cast<char*>(&value), sizeof(value));
+  void write_bytes(const void* data, const usize size) {
+    const auto offset = buffer->size();
+    buffer->resize(offset + size);
+    std::memcpy(buffer->data() + offset, data, size);
   }
 
-  template <typename T, std::size_t Size>
-  void dump(std::ofstream& out, const std::array<T, Size>& arr) const {
-    for (auto value : arr) {
-      dump(out, value);
-    }
+  std::vector<u8>* buffer;
+};
+
+// Reads back the values written by SnapshotWriter, in the same order
+class SnapshotReader final {
+public:
+  explicit SnapshotReader(const std::span<const u8> data_ref) : data(data_ref) {}
+
+  template <SnapshotValue T>
+  void read(T& value) {
+    read_bytes(&value, sizeof(value));
   }
 
-  template <typename T>
-  void dump(std::ofstream& out, const std::vector<T>& vec) const {
-    dump(out, vec.size());
-    for (auto value : vec) {
-      dump(out, value);
+  template <SnapshotValue T>
+  void read(std::vector<T>& vec) {
+    usize size = 0;
+    read(size);
+
+    if (size > (data.size() - offset) / sizeof(T)) {
+      throw std::runtime_error("Invalid snapshot: truncated data");
     }
-  }
 
-  //
-  // get specialisations
-  //
+    vec.resize(size);
+    read_bytes(vec.data(), size * sizeof(T));
+  }
 
-  static void get(std::ifstream& in, std::integral auto& value) {
-    in.read(reinterpret_cast<char*>(&value), sizeof(value));
+  [[nodiscard]] auto is_done() const -> bool {
+    return offset == data.size();
   }
 
-  template <typename T, std::size_t Size>
-  void get(std::ifstream& in, std::array<T, Size>& arr) {
-    for (auto& ref : arr) {
-      get(in, ref);
+private:
+  void read_bytes(void* destination, const usize size) {
+    if (size > data.size() - offset) {
+      throw std::runtime_error("Invalid snapshot: truncated data");
     }
+
+    std::memcpy(destination, data.data() + offset, size);
+    offset += size;
   }
 
-  template <typename T>
-  void get(std::ifstream& in, std::vector<T>& vec) {
-    {
-      std::size_t size = 0;
-      get(in, size);
-      vec.resize(size);
-    }
+  std::span<const u8> data;
+  usize offset = 0;
+};
 
-    for (auto& ref : vec) {
-      get(in, ref);
-    }
+// Components of the console that can be saved into and restored from memory
+class Snapshotable {
+public:
+  Snapshotable() = default;
+  virtual ~Snapshotable() = default;
+
+  Snapshotable(const Snapshotable&) = default;
+  Snapshotable(Snapshotable&&) = default;
+  auto operator=(const Snapshotable&) -> Snapshotable& = default;
+  auto operator=(Snapshotable&&) -> Snapshotable& = default;
+
+  virtual void save(SnapshotWriter& out) const = 0;
+  virtual void load(SnapshotReader& in) = 0;
+
+protected:
+  template <typename... Args>
+  static void dump_snapshot(SnapshotWriter& out, const Args&... args) {
+    (out.write(args), ...);
+  }
+
+  template <typename... Args>
+  static void get_snapshot(SnapshotReader& in, Args&... args) {
+    (in.read(args), ...);
   }
 };
 } // namespace nes::utility
@@ -0,0 +1,152 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "lib/common.hpp"
+
+namespace nes::utility {
+ThreadPool::ThreadPool(const usize thread_count) {
+  const auto count = std::max(thread_count, usize{1});
+
+  queues.reserve(count);
+  for (usize i = 0; i < count; ++i) {
+    queues.push_back(std::make_unique<Queue>());
+  }
+
+  workers.reserve(count - 1);
+  for (usize id = 1; id < count; ++id) {
+    workers.emplace_back([this, id] { worker_loop(id); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    const std::scoped_lock lock(mutex);
+    stopping = true;
+  }
+
+  wake_workers.notify_all();
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+auto ThreadPool::thread_count() const -> usize {
+  return queues.size();
+}
+
+void ThreadPool::for_each(const usize count, const Job& job) {
+  if (count == 0) {
+    return;
+  }
+
+  remaining = count;
+  error = nullptr;
+
+  // Contiguous chunks keep neighbouring indices on the same thread unless they get stolen
+  const auto queue_count = queues.size();
+
+  for (usize id = 0; id < queue_count; ++id) {
+    const auto begin = id * count / queue_count;
+    const auto end = (id + 1) * count / queue_count;
+
+    const std::scoped_lock lock(queues[id]->mutex);
+
+    for (auto index = begin; index < end; ++index) {
+      queues[id]->tasks.push_back({.job = &job, .index = index});
+    }
+  }
+
+  {
+    const std::scoped_lock lock(mutex);
+    ++generation;
+  }
+
+  wake_workers.notify_all();
+
+  run_tasks(0);
+
+  {
+    std::unique_lock lock(mutex);
+    wake_caller.wait(lock, [this] { return remaining == 0; });
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void ThreadPool::worker_loop(const usize id) {
+  usize seen_generation = 0;
+
+  while (true) {
+    {
+      std::unique_lock lock(mutex);
+      wake_workers.wait(lock, [&] { return stopping || generation != seen_generation; });
+
+      if (stopping) {
+        return;
+      }
+
+      seen_generation = generation;
+    }
+
+    run_tasks(id);
+  }
+}
+
+void ThreadPool::run_tasks(const usize id) {
+  while (const auto task = pop(id)) {
+    try {
+      (*task->job)(task->index);
+    } catch (...) {
+      const std::scoped_lock lock(mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+
+    if (remaining.fetch_sub(1) == 1) {
+      {
+        const std::scoped_lock lock(mutex);
+      }
+
+      wake_caller.notify_one();
+    }
+  }
+}
+
+auto ThreadPool::pop(const usize id) -> std::optional<Task> {
+  {
+    auto& own = *queues[id];
+    const std::scoped_lock lock(own.mutex);
+
+    if (!own.tasks.empty()) {
+      const auto task = own.tasks.back();
+      own.tasks.pop_back();
+      return task;
+    }
+  }
+
+  const auto queue_count = queues.size();
+
+  for (usize offset = 1; offset < queue_count; ++offset) {
+    auto& victim = *queues[(id + offset) % queue_count];
+    const std::scoped_lock lock(victim.mutex);
+
+    if (!victim.tasks.empty()) {
+      const auto task = victim.tasks.front();
+      victim.tasks.pop_front();
+      return task;
+    }
+  }
+
+  return std::nullopt;
+}
+} // namespace nes::utility
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "lib/common.hpp"
+
+namespace nes::utility {
+class ThreadPool final {
+public:
+  using Job = std::function<void(usize)>;
+
+  // The calling thread also takes part in the work, so `thread_count - 1` workers are spawned
+  explicit ThreadPool(usize thread_count);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool(ThreadPool&&) = delete;
+  auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+  auto operator=(ThreadPool&&) -> ThreadPool& = delete;
+
+  [[nodiscard]] auto thread_count() const -> usize;
+
+  // Runs `job(index)` for every index in [0, count) and blocks until all of them are done.
+  // The first exception thrown by a job is rethrown here.
+  void for_each(usize count, const Job& job);
+
+private:
+  struct Task {
+    const Job* job = nullptr;
+    usize index = 0;
+  };
+
+  // Each thread pops from the back of its own queue and steals from the front of the others
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void worker_loop(usize id);
+  void run_tasks(usize id);
+
+  [[nodiscard]] auto pop(usize id) -> std::optional<Task>;
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable wake_workers;
+  std::condition_variable wake_caller;
+
+  usize generation = 0;
+  bool stopping = false;
+
+  std::atomic<usize> remaining = 0;
+  std::exception_ptr error;
+};
+} // namespace nes::utility
@@ -0,0 +1,175 @@
+#include "xor_rle.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "lib/common.hpp"
+
+namespace nes::utility {
+namespace {
+  constexpr usize min_run = 3;
+
+  // LEB128
+  void write_varint(std::vector<u8>& out, usize value) {
+    while (value >= 0x80) {
+      out.push_back(static_cast<u8>(value | 0x80));
+      value >>= 7;
+    }
+
+    out.push_back(static_cast<u8>(value));
+  }
+
+  auto read_varint(const std::span<const u8> in, usize& pos) -> usize {
+    usize value = 0;
+
+    for (usize shift = 0; shift < sizeof(usize) * 8; shift += 7) {
+      if (pos >= in.size()) {
+        throw std::runtime_error("Invalid XOR-RLE data: truncated");
+      }
+
+      const auto byte = in[pos++];
+      value |= static_cast<usize>(byte & 0x7F) << shift;
+
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+
+    throw std::runtime_error("Invalid XOR-RLE data: bad length");
+  }
+
+  auto load_word(const u8* data) -> u64 {
+    u64 word = 0;
+    std::memcpy(&word, data, sizeof(word));
+    return word;
+  }
+} // namespace
+
+void xor_rle_encode(
+  const std::span<const u8> data,
+  const std::span<const u8> base,
+  std::vector<u8>& out
+) {
+  const auto has_base = !base.empty();
+
+  if (has_base && base.size() != data.size()) {
+    throw std::invalid_argument("XOR-RLE base size mismatch");
+  }
+
+  const auto delta = [&](const usize i) -> u8 {
+    return has_base ? data[i] ^ base[i] : data[i];
+  };
+
+  const auto size = data.size();
+  write_varint(out, size);
+
+  usize i = 0;
+
+  while (i < size) {
+    // Run of a repeated byte, worth it from 3 bytes on
+    const auto run_start = i;
+    const auto value = delta(i);
+
+    if (value == 0) {
+      // Unchanged bytes are the common case, compare them 8 at a time
+      if (has_base) {
+        while (i + 8 <= size && load_word(&data[i]) == load_word(&base[i])) {
+          i += 8;
+        }
+      } else {
+        while (i + 8 <= size && load_word(&data[i]) == 0) {
+          i += 8;
+        }
+      }
+    }
+
+    while (i < size && delta(i) == value) {
+      ++i;
+    }
+
+    if (i - run_start < min_run) {
+      i = run_start;
+    }
+
+    // Literals, until the next run
+    const auto literal_start = i;
+
+    while (i < size &&
+           (i + min_run > size || delta(i) != delta(i + 1) || delta(i) != delta(i + 2))) {
+      ++i;
+    }
+
+    write_varint(out, literal_start - run_start);
+
+    if (literal_start != run_start) {
+      out.push_back(value);
+    }
+
+    write_varint(out, i - literal_start);
+
+    for (auto j = literal_start; j < i; ++j) {
+      out.push_back(delta(j));
+    }
+  }
+}
+
+void xor_rle_decode(
+  const std::span<const u8> encoded,
+  const std::span<const u8> base,
+  std::vector<u8>& data
+) {
+  usize pos = 0;
+  const auto size = read_varint(encoded, pos);
+
+  if (!base.empty() && base.size() != size) {
+    throw std::invalid_argument("XOR-RLE base size mismatch");
+  }
+
+  data.resize(size);
+
+  usize i = 0;
+
+  while (i < size) {
+    const auto run = read_varint(encoded, pos);
+    u8 value = 0;
+
+    if (run != 0) {
+      if (pos >= encoded.size()) {
+        throw std::runtime_error("Invalid XOR-RLE data: truncated");
+      }
+
+      value = encoded[pos++];
+    }
+
+    const auto literals = read_varint(encoded, pos);
+
+    if (run > size - i || literals > size - i - run || literals > encoded.size() - pos) {
+      throw std::runtime_error("Invalid XOR-RLE data: run out of bounds");
+    }
+
+    // Pointers rather than indices: a chunk may end exactly at the end of `data` and `encoded`
+    if (base.empty()) {
+      std::fill_n(data.data() + i, run, value);
+      std::memcpy(data.data() + i + run, encoded.data() + pos, literals);
+    } else if (value == 0) {
+      std::memcpy(data.data() + i, base.data() + i, run);
+    } else {
+      for (usize j = 0; j < run; ++j) {
+        data[i + j] = base[i + j] ^ value;
+      }
+    }
+
+    if (!base.empty()) {
+      for (usize j = 0; j < literals; ++j) {
+        data[i + run + j] = encoded[pos + j] ^ base[i + run + j];
+      }
+    }
+
+    i += run + literals;
+    pos += literals;
+  }
+}
+} // namespace nes::utility
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "lib/common.hpp"
+
+namespace nes::utility {
+// Run-length encoding of `data ^ base`, meant for savestates that barely change between
+// frames: the result is a list of (run length, run byte, literal count, literal bytes) entries.
+// An empty `base` is treated as all zeros, which encodes `data` itself.
+
+// Appends the encoded `data` to `out`
+void xor_rle_encode(std::span<const u8> data, std::span<const u8> base, std::vector<u8>& out);
+
+// Replaces the contents of `data` with the decoded bytes
+void xor_rle_decode(std::span<const u8> encoded, std::span<const u8> base, std::vector<u8>& data);
+} // namespace nes::utility
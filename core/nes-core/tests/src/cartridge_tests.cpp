@@ -0,0 +1,22 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "lib/common.hpp"
+#include "lib/hash.hpp"
+#include "nes/nes.hpp"
+#include "test_rom.hpp"
+
+TEST_CASE("CHR-ROM writes are ignored", "[test][cartridge]") {
+  const auto image = nes::tests::make_rom();
+  const auto rom = nes::tests::RomFile(image);
+  auto nes = nes::tests::make_nes(rom.get_path());
+
+  REQUIRE(nes.get_rom_hash() == lib::fnv1a(image));
+
+  // Every NMI the program writes the first controller to CHR $0000
+  for (usize frame = 0; frame < 30; ++frame) {
+    nes.update_controller_state(0, static_cast<u8>(0xA5 ^ frame));
+    nes.run_frame();
+  }
+
+  REQUIRE(nes.get_rom_hash() == lib::fnv1a(image));
+}
@@ -0,0 +1,80 @@
+#include <chrono>
+#include <thread>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "lib/common.hpp"
+#include "nes/movie.hpp"
+#include "nes/nes.hpp"
+#include "nes/netplay.hpp"
+#include "test_rom.hpp"
+
+namespace {
+// Faster than the NES so the test stays short, the delay is scaled to still span a few frames
+constexpr auto FRAME_TIME = std::chrono::milliseconds(4);
+constexpr auto SETTLE_TIMEOUT = std::chrono::seconds(1);
+constexpr u32 FRAME_COUNT = 180;
+
+// Deterministic input that changes every few frames, different for each player
+auto get_input(const usize player, const u32 frame) -> u8 {
+  const auto step = static_cast<u32>(frame / (7 + player * 3));
+  return static_cast<u8>(((step * 2'654'435'761U) >> (8 + player)) & 0xF9);
+}
+} // namespace
+
+TEST_CASE("netplay sessions match a run without netplay", "[test][netplay]") {
+  const auto rom = nes::tests::RomFile(nes::tests::make_rom());
+
+  auto reference = nes::tests::make_nes(rom.get_path());
+
+  for (u32 frame = 0; frame < FRAME_COUNT; ++frame) {
+    reference.update_controller_state(0, get_input(0, frame));
+    reference.update_controller_state(1, get_input(1, frame));
+    reference.run_frame();
+  }
+
+  auto nes_a = nes::tests::make_nes(rom.get_path());
+  auto nes_b = nes::tests::make_nes(rom.get_path());
+
+  // 12 ms ± 8 ms: the transport adds a jitter in [0, jitter]
+  auto [transport_a, transport_b] = nes::netplay::LoopbackTransport::make_pair(
+    {.delay = std::chrono::milliseconds(4), .jitter = std::chrono::milliseconds(16), .seed = 7}
+  );
+
+  auto session_a = nes::netplay::Session(nes_a, transport_a, 0);
+  auto session_b = nes::netplay::Session(nes_b, transport_b, 1);
+
+  auto next_frame = std::chrono::steady_clock::now();
+
+  while (session_a.get_frame() < FRAME_COUNT || session_b.get_frame() < FRAME_COUNT) {
+    for (auto* const session : {&session_a, &session_b}) {
+      const auto frame = session->get_frame();
+      const auto port = session == &session_a ? usize{0} : usize{1};
+
+      if (frame < FRAME_COUNT) {
+        UNUSED(session->advance_frame(get_input(port, frame))); // Tried again next time
+      }
+    }
+
+    next_frame += FRAME_TIME;
+    std::this_thread::sleep_until(next_frame);
+  }
+
+  // Wait for the last remote inputs, which may still roll the consoles back
+  const auto deadline = std::chrono::steady_clock::now() + SETTLE_TIMEOUT;
+
+  while ((session_a.get_confirmed_frame() < FRAME_COUNT ||
+          session_b.get_confirmed_frame() < FRAME_COUNT) &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    session_a.poll();
+    session_b.poll();
+  }
+
+  REQUIRE(session_a.get_confirmed_frame() == FRAME_COUNT);
+  REQUIRE(session_b.get_confirmed_frame() == FRAME_COUNT);
+
+  const auto hashes = nes::Movie::get_hashes(reference);
+  REQUIRE(nes::Movie::get_hashes(nes_a) == hashes);
+  REQUIRE(nes::Movie::get_hashes(nes_b) == hashes);
+}
@@ -0,0 +1,75 @@
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "lib/common.hpp"
+#include "nes/movie.hpp"
+#include "nes/nes.hpp"
+#include "test_rom.hpp"
+
+namespace {
+void run_frames(nes::Nes& nes, const usize first_frame, const usize count) {
+  for (auto frame = first_frame; frame < first_frame + count; ++frame) {
+    nes.update_controller_state(0, static_cast<u8>(frame * 7));
+    nes.update_controller_state(1, static_cast<u8>(frame >> 2));
+    nes.run_frame();
+  }
+}
+} // namespace
+
+TEST_CASE("savestates restore the console", "[test][savestate]") {
+  const auto rom = nes::tests::RomFile(nes::tests::make_rom());
+  auto nes = nes::tests::make_nes(rom.get_path());
+  auto reference = nes::tests::make_nes(rom.get_path());
+
+  run_frames(nes, 0, 30);
+  const auto state = nes.save_state();
+  const auto hashes = nes::Movie::get_hashes(nes);
+
+  run_frames(nes, 30, 30);
+  REQUIRE(nes::Movie::get_hashes(nes) != hashes);
+
+  nes.load_state(state);
+  REQUIRE(nes::Movie::get_hashes(nes) == hashes);
+  REQUIRE(nes.save_state() == state);
+
+  run_frames(nes, 30, 30);
+  run_frames(reference, 0, 60);
+  REQUIRE(nes::Movie::get_hashes(nes) == nes::Movie::get_hashes(reference));
+}
+
+TEST_CASE("invalid savestates leave the console as it was", "[test][savestate]") {
+  const auto rom = nes::tests::RomFile(nes::tests::make_rom());
+  auto nes = nes::tests::make_nes(rom.get_path());
+  auto reference = nes::tests::make_nes(rom.get_path());
+
+  run_frames(nes, 0, 30);
+  const auto older_state = nes.save_state();
+
+  run_frames(nes, 30, 30);
+  const auto state = nes.save_state();
+
+  // Rejected once every component has been restored
+  auto trailing = older_state;
+  trailing.push_back(0);
+  REQUIRE_THROWS_AS(nes.load_state(trailing), std::runtime_error);
+  REQUIRE(nes.save_state() == state);
+
+  // Rejected half-way through
+  for (const auto size : {older_state.size() - 1, older_state.size() / 2, usize{9}}) {
+    REQUIRE_THROWS_AS(nes.load_state(std::span(older_state).first(size)), std::runtime_error);
+    REQUIRE(nes.save_state() == state);
+  }
+
+  // PRG-RAM size, right after the header
+  auto corrupted = older_state;
+  corrupted[8] ^= 0x01;
+  REQUIRE_THROWS_AS(nes.load_state(corrupted), std::runtime_error);
+  REQUIRE(nes.save_state() == state);
+
+  run_frames(nes, 60, 60);
+  run_frames(reference, 0, 120);
+  REQUIRE(nes::Movie::get_hashes(nes) == nes::Movie::get_hashes(reference));
+}
@@ -0,0 +1,159 @@
+#include "test_rom.hpp"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <ios>
+#include <random>
+#include <span>
+#include <system_error>
+#include <vector>
+
+#include "lib/common.hpp"
+#include "nes/nes.hpp"
+
+namespace nes::tests {
+namespace {
+// clang-format off
+constexpr auto PROGRAM = std::to_array<u8>({
+  0x78,             // SEI
+  0xD8,             // CLD
+  0xA2, 0xFF,       // LDX #$FF
+  0x9A,             // TXS
+  // vblank1 ($C005)
+  0x2C, 0x02, 0x20, // BIT $2002
+  0x10, 0xFB,       // BPL vblank1
+  // vblank2 ($C00A)
+  0x2C, 0x02, 0x20, // BIT $2002
+  0x10, 0xFB,       // BPL vblank2
+  // Colour i at $3F00 + i
+  0xA9, 0x3F,       // LDA #$3F
+  0x8D, 0x06, 0x20, // STA $2006
+  0xA2, 0x00,       // LDX #$00
+  0x8E, 0x06, 0x20, // STX $2006
+  // palette ($C019)
+  0x8E, 0x07, 0x20, // STX $2007
+  0xE8,             // INX
+  0xE0, 0x20,       // CPX #$20
+  0xD0, 0xF8,       // BNE palette
+  0xA9, 0x80,       // LDA #$80
+  0x8D, 0x00, 0x20, // STA $2000
+  0xA9, 0x1E,       // LDA #$1E
+  0x8D, 0x01, 0x20, // STA $2001
+  // main ($C02B)
+  0xE6, 0x10,       // INC $10
+  0x4C, 0x2B, 0xC0, // JMP main
+  // nmi ($C030)
+  0xA9, 0x01,       // LDA #$01
+  0x8D, 0x16, 0x40, // STA $4016
+  0xA9, 0x00,       // LDA #$00
+  0x8D, 0x16, 0x40, // STA $4016
+  0xA2, 0x08,       // LDX #$08
+  // read ($C03C)
+  0xAD, 0x16, 0x40, // LDA $4016
+  0x4A,             // LSR A
+  0x26, 0x00,       // ROL $00
+  0xAD, 0x17, 0x40, // LDA $4017
+  0x4A,             // LSR A
+  0x26, 0x01,       // ROL $01
+  0xCA,             // DEX
+  0xD0, 0xF1,       // BNE read
+  // Mix the inputs
+  0xA5, 0x02,       // LDA $02
+  0x45, 0x00,       // EOR $00
+  0x65, 0x01,       // ADC $01
+  0x85, 0x02,       // STA $02
+  0xA4, 0x03,       // LDY $03
+  0x99, 0x00, 0x03, // STA $0300,Y
+  0xE6, 0x03,       // INC $03
+  // Backdrop colour
+  0xA9, 0x3F,       // LDA #$3F
+  0x8D, 0x06, 0x20, // STA $2006
+  0xA9, 0x00,       // LDA #$00
+  0x8D, 0x06, 0x20, // STA $2006
+  0xA5, 0x02,       // LDA $02
+  0x29, 0x3F,       // AND #$3F
+  0x8D, 0x07, 0x20, // STA $2007
+  // CHR $0000
+  0xA9, 0x00,       // LDA #$00
+  0x8D, 0x06, 0x20, // STA $2006
+  0x8D, 0x06, 0x20, // STA $2006
+  0xA5, 0x00,       // LDA $00
+  0x8D, 0x07, 0x20, // STA $2007
+  // Scroll
+  0xA9, 0x80,       // LDA #$80
+  0x8D, 0x00, 0x20, // STA $2000
+  0xA5, 0x00,       // LDA $00
+  0x8D, 0x05, 0x20, // STA $2005
+  0xA5, 0x01,       // LDA $01
+  0x8D, 0x05, 0x20, // STA $2005
+  0x40,             // RTI
+});
+// clang-format on
+
+constexpr u16 RESET_VECTOR = 0xC000;
+constexpr u16 NMI_VECTOR = 0xC030;
+
+// Every row uses a different mix of the 4 colours
+constexpr auto TILE = std::to_array<u8>({
+  0x0F, 0x33, 0x55, 0xFF, 0x00, 0xF0, 0xCC, 0xAA, // Low bitplane
+  0x3C, 0x66, 0x0F, 0x00, 0xFF, 0x99, 0xC3, 0x5A, // High bitplane
+});
+} // namespace
+
+auto make_rom() -> std::vector<u8> {
+  constexpr usize prg_size = 0x4000;
+  constexpr usize chr_size = 0x2000;
+
+  auto rom = std::vector<u8>(16 + prg_size + chr_size);
+
+  // iNES header: NROM, 16KB PRG-ROM, 8KB CHR-ROM
+  rom[0] = 'N';
+  rom[1] = 'E';
+  rom[2] = 'S';
+  rom[3] = 0x1A;
+  rom[4] = 1;
+  rom[5] = 1;
+
+  const auto prg = std::span(rom).subspan(16, prg_size);
+  std::ranges::copy(PROGRAM, prg.begin());
+
+  // NMI and reset vectors
+  prg[prg_size - 6] = NMI_VECTOR & 0xFF;
+  prg[prg_size - 5] = NMI_VECTOR >> 8;
+  prg[prg_size - 4] = RESET_VECTOR & 0xFF;
+  prg[prg_size - 3] = RESET_VECTOR >> 8;
+
+  std::ranges::copy(TILE, rom.begin() + 16 + prg_size);
+
+  return rom;
+}
+
+RomFile::RomFile(const std::span<const u8> rom) {
+  auto random = std::random_device();
+  path = std::filesystem::temp_directory_path() /
+         std::format("nes-core-tests-{:08x}{:08x}.nes", random(), random());
+
+  auto file = std::ofstream(path, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(rom.data()), static_cast<std::streamsize>(rom.size()));
+}
+
+RomFile::~RomFile() {
+  auto error = std::error_code();
+  std::filesystem::remove(path, error);
+}
+
+auto RomFile::get_path() const -> const std::filesystem::path& {
+  return path;
+}
+
+auto make_nes(const std::filesystem::path& rom_path) -> Nes {
+  auto nes = Nes();
+  nes.set_app_path(NES_CORE_TESTS_APP_PATH);
+  nes.load(rom_path);
+  nes.power_on();
+  return nes;
+}
+} // namespace nes::tests
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "lib/common.hpp"
+#include "nes/nes.hpp"
+
+namespace nes::tests {
+// NROM cartridge with 8KB of CHR-ROM. Every NMI the program reads both controllers, mixes them
+// into RAM ($02 and a history at $0300), the backdrop colour and the scroll, and writes the
+// first controller to CHR $0000. Tile 0 fills the background and sprite 0 sits on it.
+[[nodiscard]] auto make_rom() -> std::vector<u8>;
+
+// Consoles load their ROM from a file: written to a unique temporary one, removed when done
+class RomFile final {
+public:
+  explicit RomFile(std::span<const u8> rom);
+  ~RomFile();
+
+  RomFile(const RomFile&) = delete;
+  auto operator=(const RomFile&) -> RomFile& = delete;
+  RomFile(RomFile&&) = delete;
+  auto operator=(RomFile&&) -> RomFile& = delete;
+
+  [[nodiscard]] auto get_path() const -> const std::filesystem::path&;
+
+private:
+  std::filesystem::path path;
+};
+
+// Powered on, with the palette copied next to the tests
+[[nodiscard]] auto make_nes(const std::filesystem::path& rom_path) -> Nes;
+} // namespace nes::tests
@@ -0,0 +1,104 @@
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "utility/xor_rle.hpp"
+
+namespace {
+auto round_trip(const std::vector<std::uint8_t>& data, const std::vector<std::uint8_t>& base)
+  -> std::vector<std::uint8_t> {
+  auto encoded = std::vector<std::uint8_t>();
+  nes::utility::xor_rle_encode(data, base, encoded);
+
+  auto decoded = std::vector<std::uint8_t>{0xAA}; // Replaced by the decoded bytes
+  nes::utility::xor_rle_decode(encoded, base, decoded);
+  return decoded;
+}
+
+// Runs, literals and a run at the very end
+auto make_state() -> std::vector<std::uint8_t> {
+  auto data = std::vector<std::uint8_t>(64, 0);
+
+  for (std::size_t i = 10; i < 20; ++i) {
+    data[i] = static_cast<std::uint8_t>(i * 7);
+  }
+
+  for (std::size_t i = 30; i < 45; ++i) {
+    data[i] = 0x42;
+  }
+
+  data[50] = 1;
+  data[52] = 2;
+
+  return data;
+}
+} // namespace
+
+TEST_CASE("keyframes decode to the original data", "[test][xor_rle]") {
+  const auto data = make_state();
+  REQUIRE(round_trip(data, {}) == data);
+
+  // Ends with a run and no literals
+  const auto zeros = std::vector<std::uint8_t>(16, 0);
+  REQUIRE(round_trip(zeros, {}) == zeros);
+
+  const auto filled = std::vector<std::uint8_t>(33, 0x5A);
+  REQUIRE(round_trip(filled, {}) == filled);
+}
+
+TEST_CASE("deltas decode against their base", "[test][xor_rle]") {
+  const auto base = make_state();
+
+  auto data = base;
+  data[0] ^= 0xFF;
+  data[31] = 0x43;
+  data[60] = 9;
+  REQUIRE(round_trip(data, base) == data);
+
+  // Unchanged: a single run up to the end
+  REQUIRE(round_trip(base, base) == base);
+
+  // Changed up to the last byte
+  data.back() ^= 0x01;
+  REQUIRE(round_trip(data, base) == data);
+}
+
+TEST_CASE("empty input round trips", "[test][xor_rle]") {
+  REQUIRE(round_trip({}, {}).empty());
+
+  // Nothing at all isn't a valid encoding
+  auto decoded = std::vector<std::uint8_t>();
+  REQUIRE_THROWS_AS(nes::utility::xor_rle_decode({}, {}, decoded), std::runtime_error);
+}
+
+TEST_CASE("truncated input is rejected", "[test][xor_rle]") {
+  const auto base = make_state();
+  auto data = base;
+  data[5] = 0x77;
+  data[63] = 0x01;
+
+  for (const auto& reference : {std::vector<std::uint8_t>(), base}) {
+    auto encoded = std::vector<std::uint8_t>();
+    nes::utility::xor_rle_encode(data, reference, encoded);
+
+    for (std::size_t size = 0; size < encoded.size(); ++size) {
+      auto decoded = std::vector<std::uint8_t>();
+      const auto truncated = std::span(encoded).first(size);
+      REQUIRE_THROWS_AS(
+        nes::utility::xor_rle_decode(truncated, reference, decoded), std::runtime_error
+      );
+    }
+  }
+}
+
+TEST_CASE("a base of another size is rejected", "[test][xor_rle]") {
+  const auto data = make_state();
+  const auto base = std::vector<std::uint8_t>(data.size() + 1, 0);
+
+  auto encoded = std::vector<std::uint8_t>();
+  REQUIRE_THROWS_AS(nes::utility::xor_rle_encode(data, base, encoded), std::invalid_argument);
+}